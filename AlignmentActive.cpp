@@ -10,9 +10,18 @@
 #include <stdlib.h>
 #include <sstream>
 #include <fstream>
+#include <limits>
+#include <functional>
 #include <chrono>
 #include <ctime>
 #include <cstring>
+#ifdef __linux__
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+#endif
 
 #define ECHO(x) std::cout << #x << std::endl; x
 #define EVAL(x) std::cout << #x << ": " << (x) << std::endl
@@ -39,6 +48,29 @@ void layerer_log_default(const std::string& str)
 	return;
 };
 
+// set in a forked child, whose logs are dropped because the log queue or the stream may be locked by threads that are not in the child
+bool activeForkChild = false;
+
+// the forked layerer does not log, because the locks of the streams may be held by threads that are not in the child
+void layerer_log_none(const std::string& str)
+{
+};
+
+#ifdef __linux__
+// close all of the descriptors of a forked child except the given one
+void activeForkCloseDescriptors(int fdA)
+{
+#ifdef SYS_close_range
+	if (syscall(SYS_close_range, 3, fdA - 1, 0) == 0 && syscall(SYS_close_range, fdA + 1, ~0U, 0) == 0)
+		return;
+#endif
+	long n = sysconf(_SC_OPEN_MAX);
+	for (int k = 3; k < n; k++)
+		if (k != fdA)
+			close(k);
+};
+#endif
+
 ActiveSystem::ActiveSystem() : bits(16), block(0)
 {
 }
@@ -60,6 +92,326 @@ std::size_t Alignment::ActiveSystem::next(int bitsA)
 	return blockA << this->bits;
 }
 
+// log-linear buckets with 4 sub-buckets per power of 2
+inline std::size_t lockStatsBucket(std::size_t x)
+{
+	if (x < 4)
+		return x;
+	std::size_t b = 2;
+	while (x >> (b+1))
+		b++;
+	return 4*(b-1) + ((x >> (b-2)) & 3);
+}
+
+inline std::size_t lockStatsBucketValue(std::size_t i)
+{
+	if (i < 4)
+		return i;
+	std::size_t b = i/4 + 1;
+	std::size_t w = (std::size_t)1 << (b-2);
+	return (4 + i%4) * w + w/2;
+}
+
+std::size_t lockStatsPercentile(const std::size_t* buckets, std::size_t count, double q)
+{
+	if (!count)
+		return 0;
+	std::size_t r = (std::size_t)std::ceil(q * (double)count);
+	if (!r)
+		r = 1;
+	std::size_t c = 0;
+	for (std::size_t i = 0; i < ActiveLockStats::bucketsSize; i++)
+	{
+		c += buckets[i];
+		if (c >= r)
+			return lockStatsBucketValue(i);
+	}
+	return lockStatsBucketValue(ActiveLockStats::bucketsSize-1);
+}
+
+void Alignment::ActiveLockStats::record(const char* site, std::size_t waitNanos, std::size_t holdNanos)
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+	auto& st = this->sites[site];
+	st.count++;
+	st.waitTotal += waitNanos;
+	st.waitMax = std::max(st.waitMax, waitNanos);
+	st.holdTotal += holdNanos;
+	st.holdMax = std::max(st.holdMax, holdNanos);
+	st.waitBuckets[lockStatsBucket(waitNanos)]++;
+	st.holdBuckets[lockStatsBucket(holdNanos)]++;
+}
+
+void Alignment::ActiveLockStats::reset()
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+	this->sites.clear();
+}
+
+std::string Alignment::ActiveLockStats::report(std::size_t top)
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+	std::vector<std::pair<std::size_t, const char*>> ll;
+	ll.reserve(this->sites.size());
+	for (auto& p : this->sites)
+		ll.push_back(std::make_pair(p.second.waitTotal, p.first));
+	std::sort(ll.begin(), ll.end(), [](const std::pair<std::size_t, const char*>& a, const std::pair<std::size_t, const char*>& b) {return a.first > b.first;});
+	std::ostringstream out;
+	out << "lock stats";
+#ifndef ALIGNMENTACTIVE_LOCK_STATS
+	out << "\tdisabled: compile with ALIGNMENTACTIVE_LOCK_STATS";
+#endif
+	for (std::size_t i = 0; i < top && i < ll.size(); i++)
+	{
+		auto& st = this->sites[ll[i].second];
+		out << std::endl << ll[i].second
+			<< "\tcount: " << st.count
+			<< "\twait total: " << st.waitTotal
+			<< "\twait p50: " << lockStatsPercentile(st.waitBuckets, st.count, 0.5)
+			<< "\twait p99: " << lockStatsPercentile(st.waitBuckets, st.count, 0.99)
+			<< "\twait max: " << st.waitMax
+			<< "\thold total: " << st.holdTotal
+			<< "\thold p50: " << lockStatsPercentile(st.holdBuckets, st.count, 0.5)
+			<< "\thold p99: " << lockStatsPercentile(st.holdBuckets, st.count, 0.99)
+			<< "\thold max: " << st.holdMax;
+	}
+	return out.str();
+}
+
+void Alignment::ActiveSharedMutex::lock()
+{
+	std::unique_lock<std::mutex> guard(this->mutex);
+	this->writersWaiting++;
+	this->writersCondition.wait(guard, [this] {return !this->writer && !this->readers;});
+	this->writersWaiting--;
+	this->writer = true;
+}
+
+void Alignment::ActiveSharedMutex::unlock()
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+	this->writer = false;
+	if (this->writersWaiting)
+		this->writersCondition.notify_one();
+	else
+		this->readersCondition.notify_all();
+}
+
+void Alignment::ActiveSharedMutex::lock_shared()
+{
+	std::unique_lock<std::mutex> guard(this->mutex);
+	this->readersCondition.wait(guard, [this] {return !this->writer && !this->writersWaiting;});
+	this->readers++;
+}
+
+void Alignment::ActiveSharedMutex::unlock_shared()
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+	this->readers--;
+	if (!this->readers && this->writersWaiting)
+		this->writersCondition.notify_one();
+}
+
+ActiveLogQueue::ActiveLogQueue(std::size_t capacityA) : capacity(1), enqueuePos(0), dequeuePos(0), terminate(false)
+{
+	while (this->capacity < capacityA)
+		this->capacity <<= 1;
+	this->records.reset(new Record[this->capacity]);
+	for (std::size_t i = 0; i < this->capacity; i++)
+	{
+		this->records[i].sequence.store(i, std::memory_order_relaxed);
+		this->records[i].active = 0;
+	}
+	this->thread = std::thread(&ActiveLogQueue::run, this);
+}
+
+ActiveLogQueue::~ActiveLogQueue()
+{
+	this->terminate.store(true, std::memory_order_release);
+	if (this->thread.joinable())
+		this->thread.join();
+}
+
+void Alignment::ActiveLogQueue::push(Active& active, const std::string& str)
+{
+	auto mask = this->capacity - 1;
+	Record* rec = 0;
+	std::size_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+	while (true)
+	{
+		rec = &this->records[pos & mask];
+		std::size_t seq = rec->sequence.load(std::memory_order_acquire);
+		if (seq == pos)
+		{
+			if (this->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (seq < pos)
+		{
+			// full
+			std::this_thread::yield();
+			pos = this->enqueuePos.load(std::memory_order_relaxed);
+		}
+		else
+			pos = this->enqueuePos.load(std::memory_order_relaxed);
+	}
+	rec->active = &active;
+	rec->text.assign(str);
+	rec->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void Alignment::ActiveLogQueue::flush()
+{
+	std::size_t pos = this->enqueuePos.load(std::memory_order_acquire);
+	while (this->dequeuePos.load(std::memory_order_acquire) < pos && this->thread.joinable())
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+void Alignment::ActiveLogQueue::run()
+{
+	auto mask = this->capacity - 1;
+	std::size_t idle = 0;
+	while (true)
+	{
+		std::size_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+		auto rec = &this->records[pos & mask];
+		if (rec->sequence.load(std::memory_order_acquire) == pos + 1)
+		{
+			try
+			{
+				rec->active->log(*rec->active, rec->text);
+			}
+			catch (const std::exception&)
+			{
+			}
+			rec->sequence.store(pos + this->capacity, std::memory_order_release);
+			this->dequeuePos.store(pos + 1, std::memory_order_release);
+			idle = 0;
+		}
+		else if (this->terminate.load(std::memory_order_acquire) 
+			&& pos == this->enqueuePos.load(std::memory_order_acquire))
+			break;
+		else if (idle < 100)
+		{
+			idle++;
+			std::this_thread::yield();
+		}
+		else
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+ActiveArena::ActiveArena(std::size_t blockSizeA) : blockSize(blockSizeA), blockUsed(0), blockCapacity(0), allocated(0)
+{
+}
+
+const std::size_t arenaAlign = alignof(std::max_align_t);
+
+// allocations larger than a quarter of a block get their own block so that little of a block is wasted
+void* Alignment::ActiveArena::allocate(std::size_t size)
+{
+	size = (size + arenaAlign - 1) / arenaAlign * arenaAlign;
+	this->allocated += size;
+	if (size > this->blockSize / 4)
+	{
+		auto block = std::unique_ptr<char[]>(new char[size]);
+		auto p = block.get();
+		if (this->blocks.size())
+			this->blocks.insert(this->blocks.end() - 1, std::move(block));
+		else
+		{
+			this->blocks.push_back(std::move(block));
+			this->blockUsed = size;
+			this->blockCapacity = size;
+		}
+		return p;
+	}
+	if (!this->blocks.size() || this->blockUsed + size > this->blockCapacity)
+	{
+		this->blocks.push_back(std::unique_ptr<char[]>(new char[this->blockSize]));
+		this->blockUsed = 0;
+		this->blockCapacity = this->blockSize;
+	}
+	auto p = this->blocks.back().get() + this->blockUsed;
+	this->blockUsed += size;
+	return p;
+}
+
+std::size_t Alignment::activeArenaTransformRepaSize(std::size_t dimension, std::size_t volume)
+{
+	auto align = [](std::size_t x) {return (x + arenaAlign - 1) / arenaAlign * arenaAlign;};
+	return align(sizeof(TransformRepa)) + align(2 * dimension * sizeof(std::size_t)) + volume;
+}
+
+TransformRepaPtr Alignment::activeArenaTransformRepa(const ActiveArenaPtr& arena, std::size_t dimension, std::size_t volume)
+{
+	auto align = [](std::size_t x) {return (x + arenaAlign - 1) / arenaAlign * arenaAlign;};
+	auto p = static_cast<char*>(arena->allocate(activeArenaTransformRepaSize(dimension, volume)));
+	auto tr = new (p) TransformRepa();
+	p += align(sizeof(TransformRepa));
+	tr->dimension = dimension;
+	tr->vectorVar = reinterpret_cast<std::size_t*>(p);
+	tr->shape = tr->vectorVar + dimension;
+	p += align(2 * dimension * sizeof(std::size_t));
+	tr->arr = reinterpret_cast<unsigned char*>(p);
+	// the arrays belong to the arena so they are detached before the destructor
+	return TransformRepaPtr(tr, [arena](TransformRepa* tr) {
+		tr->vectorVar = 0;
+		tr->shape = 0;
+		tr->arr = 0;
+		tr->~TransformRepa();
+	});
+}
+
+TransformRepaPtr Alignment::activeArenaTransformRepa(const ActiveArenaPtr& arena, const TransformRepa& tr)
+{
+	auto n = tr.dimension;
+	std::size_t sz = 1;
+	for (std::size_t i = 0; i < n; i++)
+		sz *= tr.shape[i];
+	auto tr1 = activeArenaTransformRepa(arena, n, sz);
+	for (std::size_t i = 0; i < n; i++)
+	{
+		tr1->vectorVar[i] = tr.vectorVar[i];
+		tr1->shape[i] = tr.shape[i];
+	}
+	std::memcpy(tr1->arr, tr.arr, sz);
+	tr1->derived = tr.derived;
+	tr1->valency = tr.valency;
+	return tr1;
+}
+
+void Alignment::ActiveVarValueMap::clear(std::size_t capacity)
+{
+	std::size_t size = 16;
+	while (size < 2 * capacity)
+		size *= 2;
+	if (size > this->keys.size())
+	{
+		this->keys.assign(size, 0);
+		this->values.assign(size, 0);
+		this->stamps.assign(size, 0);
+		this->shift = 64;
+		while (((std::size_t)1 << (64 - this->shift)) < size)
+			this->shift--;
+	}
+	this->stamp++;
+	this->count = 0;
+}
+
+void Alignment::ActiveVarValueMap::grow()
+{
+	auto keys0 = std::move(this->keys);
+	auto values0 = std::move(this->values);
+	auto stamps0 = std::move(this->stamps);
+	auto stamp0 = this->stamp;
+	this->keys.clear();
+	this->clear(keys0.size());
+	for (std::size_t i = 0; i < keys0.size(); i++)
+		if (stamps0[i] == stamp0)
+			this->assign(keys0[i], values0[i]);
+}
+
 std::ostream& operator<<(std::ostream& out, const ActiveEventRepa& ev)
 {
 	out << "(" << ev.id << ",";
@@ -80,11 +432,414 @@ std::ostream& operator<<(std::ostream& out, const ActiveEventSparse& ev)
 	return out;
 }
 
-Active::Active(std::string nameA) : name(nameA), terminate(false), log(log_default), layerer_log(layerer_log_default), underlyingEventUpdated(0), historyOverflow(false), historyEvent(0), historySize(0), continousIs(false), bits(16), var(0), varSlice(0), induceThreshold(100), updateProhibit(false), logging(false), summary(false), updateCallback(0),  induceCallback(0), client(0), historySliceCachingIs(false), historySliceCumulativeIs(false), frameUnderlyingDynamicIs(false), frameHistoryDynamicIs(false), underlyingOffsetIs(false)
+Active::Active(std::string nameA) : name(nameA), terminate(false), log(log_default), layerer_log(layerer_log_default), underlyingEventUpdated(0), historyOverflow(false), historyEvent(0), historySize(0), continousIs(false), bits(16), var(0), varSlice(0), induceThreshold(100), updateProhibit(false), logging(false), summary(false), updateCallback(0),  induceCallback(0), client(0), historySliceCachingIs(false), historySliceCumulativeIs(false), frameUnderlyingDynamicIs(false), frameHistoryDynamicIs(false), underlyingOffsetIs(false), eventSparseLazyIs(false), eventSparseStale(false), sliceIndicatorIs(false), decompGeneration(0), historyGeneration(0), transitionIndexIs(false), induceSampleSize(0), induceCountsIs(false), induceDuration(0.0), pruneCursor(0)
+{
+}
+
+Alignment::Active::~Active()
+{
+	if (this->logQueue)
+		this->logQueue->flush();
+}
+
+HistorySparseArrayPtr Alignment::ActiveEventSparsePool::get(std::size_t capacity)
+{
+	auto& ll = this->states[capacity];
+	for (auto& hr : ll)
+		if (hr.use_count() == 1)
+		{
+			// the count is read relaxed, so order the last consumer's reads of the state before its reuse
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return hr;
+		}
+	auto hr = std::make_shared<HistorySparseArray>(1,capacity);
+	if (ll.size() < this->sizeMax)
+		ll.push_back(hr);
+	return hr;
+}
+
+void Alignment::ActiveTransitionIndex::increment(std::size_t sliceA, std::size_t sliceB)
+{
+	std::unique_lock<std::shared_mutex> guard(this->mutex);
+	auto& ss = this->slicesSuccessors[sliceA];
+	auto& c = ss.counts[sliceB];
+	if (c)
+		ss.countsOrdered.erase(std::make_pair(c, sliceB));
+	c++;
+	ss.countsOrdered.insert(std::make_pair(c, sliceB));
+	ss.total++;
+}
+
+void Alignment::ActiveTransitionIndex::decrement(std::size_t sliceA, std::size_t sliceB)
+{
+	std::unique_lock<std::shared_mutex> guard(this->mutex);
+	auto it = this->slicesSuccessors.find(sliceA);
+	if (it == this->slicesSuccessors.end())
+		return;
+	auto& ss = it->second;
+	auto it1 = ss.counts.find(sliceB);
+	if (it1 == ss.counts.end())
+		return;
+	auto& c = it1->second;
+	ss.countsOrdered.erase(std::make_pair(c, sliceB));
+	c--;
+	ss.total--;
+	if (c)
+		ss.countsOrdered.insert(std::make_pair(c, sliceB));
+	else
+		ss.counts.erase(it1);
+	if (!ss.total)
+		this->slicesSuccessors.erase(it);
+}
+
+void Alignment::ActiveTransitionIndex::assign(std::size_t sliceA, const SizeSizeMap& successors)
+{
+	Successors ss;
+	ss.counts.reserve(successors.size());
+	for (auto& pp : successors)
+		if (pp.second)
+		{
+			ss.counts[pp.first] = pp.second;
+			ss.countsOrdered.insert(std::make_pair(pp.second, pp.first));
+			ss.total += pp.second;
+		}
+	std::unique_lock<std::shared_mutex> guard(this->mutex);
+	if (ss.total)
+		this->slicesSuccessors[sliceA] = std::move(ss);
+	else
+		this->slicesSuccessors.erase(sliceA);
+}
+
+void Alignment::ActiveTransitionIndex::build(const std::unordered_map<std::size_t, SizeSizeMap>& nexts)
+{
+	std::unordered_map<std::size_t, Successors> slicesSuccessors1;
+	slicesSuccessors1.reserve(nexts.size());
+	for (auto& pp : nexts)
+	{
+		auto& ss = slicesSuccessors1[pp.first];
+		ss.counts.reserve(pp.second.size());
+		for (auto& qq : pp.second)
+			if (qq.second)
+			{
+				ss.counts[qq.first] = qq.second;
+				ss.countsOrdered.insert(std::make_pair(qq.second, qq.first));
+				ss.total += qq.second;
+			}
+		if (!ss.total)
+			slicesSuccessors1.erase(pp.first);
+	}
+	std::unique_lock<std::shared_mutex> guard(this->mutex);
+	this->slicesSuccessors.swap(slicesSuccessors1);
+}
+
+DoubleSizePairList Alignment::ActiveTransitionIndex::topNext(std::size_t sliceA, std::size_t k) const
+{
+	DoubleSizePairList ll;
+	std::shared_lock<std::shared_mutex> guard(this->mutex);
+	auto it = this->slicesSuccessors.find(sliceA);
+	if (it == this->slicesSuccessors.end())
+		return ll;
+	auto& ss = it->second;
+	ll.reserve(std::min(k, ss.countsOrdered.size()));
+	for (auto& pp : ss.countsOrdered)
+	{
+		if (ll.size() >= k)
+			break;
+		ll.push_back(DoubleSizePair((double)pp.first / (double)ss.total, pp.second));
+	}
+	return ll;
+}
+
+double Alignment::ActiveTransitionIndex::probability(std::size_t sliceA, std::size_t sliceB) const
+{
+	std::shared_lock<std::shared_mutex> guard(this->mutex);
+	auto it = this->slicesSuccessors.find(sliceA);
+	if (it == this->slicesSuccessors.end())
+		return 0.0;
+	auto& ss = it->second;
+	auto it1 = ss.counts.find(sliceB);
+	if (it1 == ss.counts.end())
+		return 0.0;
+	return (double)it1->second / (double)ss.total;
+}
+
+void Alignment::Active::sampleInsert(std::size_t sliceA, std::size_t historyEventA)
+{
+	auto& idx = this->historySampleIndex;
+	if (idx.size() != this->historySize)
+		idx.assign(this->historySize, 0);
+	auto cap = this->induceSampleSize;
+	auto& ll = this->historySlicesSample[sliceA];
+	if (ll.size() < cap)
+	{
+		ll.push_back(historyEventA);
+		idx[historyEventA] = ll.size();
+		return;
+	}
+	auto it = this->historySlicesSetEvent.find(sliceA);
+	std::size_t size = it != this->historySlicesSetEvent.end() ? it->second.size() : 1;
+	std::size_t r = this->sampleGenerator() % std::max(size, (std::size_t)1);
+	if (r < cap)
+	{
+		idx[ll[r]] = 0;
+		ll[r] = historyEventA;
+		idx[historyEventA] = r + 1;
+	}
+}
+
+void Alignment::Active::sampleRemove(std::size_t sliceA, std::size_t historyEventA)
+{
+	auto& idx = this->historySampleIndex;
+	if (historyEventA >= idx.size() || !idx[historyEventA])
+		return;
+	auto it = this->historySlicesSample.find(sliceA);
+	if (it == this->historySlicesSample.end())
+		return;
+	auto& ll = it->second;
+	auto k = idx[historyEventA];
+	idx[historyEventA] = 0;
+	if (k <= ll.size() && ll[k-1] == historyEventA)
+	{
+		auto last = ll.back();
+		ll[k-1] = last;
+		ll.pop_back();
+		if (last != historyEventA)
+			idx[last] = k;
+	}
+	if (!ll.size())
+		this->historySlicesSample.erase(it);
+}
+
+// sample the slice's events afresh by a single reservoir pass
+void Alignment::Active::sampleSlice(std::size_t sliceA)
+{
+	auto& idx = this->historySampleIndex;
+	if (idx.size() != this->historySize)
+		idx.assign(this->historySize, 0);
+	auto cap = this->induceSampleSize;
+	auto it = this->historySlicesSample.find(sliceA);
+	if (it != this->historySlicesSample.end())
+	{
+		for (auto j : it->second)
+			if (j < idx.size())
+				idx[j] = 0;
+		this->historySlicesSample.erase(it);
+	}
+	auto it1 = this->historySlicesSetEvent.find(sliceA);
+	if (!cap || it1 == this->historySlicesSetEvent.end() || !it1->second.size())
+		return;
+	auto& ll = this->historySlicesSample[sliceA];
+	ll.reserve(std::min(cap, it1->second.size()));
+	std::size_t k = 0;
+	for (auto j : it1->second)
+	{
+		k++;
+		if (ll.size() < cap)
+		{
+			ll.push_back(j);
+			idx[j] = ll.size();
+		}
+		else
+		{
+			std::size_t r = this->sampleGenerator() % k;
+			if (r < cap)
+			{
+				idx[ll[r]] = 0;
+				ll[r] = j;
+				idx[j] = r + 1;
+			}
+		}
+	}
+}
+
+void Alignment::Active::samplesRebuild()
+{
+	this->historySlicesSample.clear();
+	this->historySampleIndex.assign(this->induceSampleSize ? this->historySize : 0, 0);
+	if (!this->induceSampleSize)
+		return;
+	for (auto& pp : this->historySlicesSetEvent)
+		this->sampleSlice(pp.first);
+}
+
+// the entropy of a repa variable of a slice from its counts, given the reciprocal of the slice size
+inline double sliceCountsEntropy(const SizeList& ll, double f)
+{
+	double e = 0.0;
+	for (auto c : ll)
+		if (c)
+		{
+			double a = (double)c * f;
+			e -= a * std::log(a);
+		}
+	return e;
+}
+
+// the counts follow the induce copy of the current frame, computed variables are not promoted
+// the counts of a slice are only kept from when it reaches half of the induce threshold, at which point they are built
+// from its events, so that update does not count the slices that are far from being induced
+void Alignment::Active::sliceCountsEvent(std::size_t sliceA, std::size_t historyEventA, bool add)
+{
+	auto itc = this->historySlicesCounts.find(sliceA);
+	if (itc == this->historySlicesCounts.end())
+	{
+		if (add && this->sliceCountsNear(sliceA))
+			this->sliceCounts(sliceA);
+		return;
+	}
+	auto& comp = this->induceVarComputeds;
+	auto& excl = this->induceVarExclusions;
+	auto& slpp = this->underlyingSlicesParent;
+	auto promote = this->underlyingOffsetIs;
+	auto& proms = this->underlyingsVarsOffset;
+	std::size_t block1 = (std::size_t)1 << this->bits;
+	auto j = historyEventA;
+	auto& cc = itc->second;
+	auto count = [add](std::size_t& c)
+	{
+		if (add)
+			c++;
+		else if (c)
+			c--;
+	};
+	auto countSparse = [add, &cc](std::size_t w)
+	{
+		if (add)
+			cc.sparse[w]++;
+		else
+		{
+			auto it = cc.sparse.find(w);
+			if (it != cc.sparse.end())
+			{
+				if (it->second > 1)
+					it->second--;
+				else
+					cc.sparse.erase(it);
+			}
+		}
+	};
+	count(cc.size);
+	for (auto& hr : this->underlyingHistoryRepa)
+	{
+		auto z = hr->size;
+		auto n = hr->dimension;
+		auto vv = hr->vectorVar;
+		auto sh = hr->shape;
+		auto rr = hr->arr;
+		if (j >= z)
+			continue;
+		for (std::size_t i = 0; i < n; i++)
+		{
+			auto v = vv[i];
+			if (excl.count(v))
+				continue;
+			unsigned char u = hr->evient ? rr[j*n + i] : rr[i*z + j];
+			if (comp.count(v))
+			{
+				auto s = sh[i];
+				std::size_t b = 0; 
+				if (s)
+				{
+					s--;
+					while (s >> b)
+						b++;
+				}
+				std::size_t w = block1 + (v << 12) + (b << 8) + u;
+				countSparse(w);
+				auto it = slpp.find(w);
+				while (it != slpp.end() && it->second)
+				{
+					countSparse(it->second);
+					it = slpp.find(it->second);
+				}
+			}
+			else
+			{
+				auto& ll = cc.repa[v];
+				if (ll.size() < sh[i])
+					ll.resize(sh[i]);
+				if (u < ll.size())
+					count(ll[u]);
+			}
+		}
+	}
+	std::size_t h = 0;
+	for (auto& hr : this->underlyingHistorySparse)
+	{
+		if (j < hr->size)
+		{
+			auto v = hr->arr[j];
+			auto w = v;
+			if (v && promote)
+				this->varPromote(proms[h], w);
+			countSparse(w);
+			auto it = v ? slpp.find(v) : slpp.end();
+			while (it != slpp.end() && it->second)
+			{
+				auto w2 = it->second;
+				if (promote)
+					this->varPromote(proms[h], w2);
+				countSparse(w2);
+				it = slpp.find(it->second);
+			}
+		}
+		h++;
+	}
+	if (!cc.size)
+		this->historySlicesCounts.erase(sliceA);
+}
+
+bool Alignment::Active::sliceCountsNear(std::size_t sliceA) const
+{
+	auto it = this->historySlicesSetEvent.find(sliceA);
+	return it != this->historySlicesSetEvent.end() && it->second.size() * 2 >= this->induceThreshold;
+}
+
+void Alignment::Active::sliceCounts(std::size_t sliceA)
+{
+	this->historySlicesCounts.erase(sliceA);
+	auto it = this->historySlicesSetEvent.find(sliceA);
+	if (it == this->historySlicesSetEvent.end() || !it->second.size())
+		return;
+	this->historySlicesCounts[sliceA];
+	for (auto j : it->second)
+		this->sliceCountsEvent(sliceA, j, true);
+}
+
+void Alignment::Active::slicesCountsRebuild()
 {
+	this->historySlicesCounts.clear();
+	if (!this->induceCountsIs)
+		return;
+	for (auto& pp : this->historySlicesSetEvent)
+		if (this->sliceCountsNear(pp.first))
+			this->sliceCounts(pp.first);
+}
+
+ActiveEventSparse Alignment::Active::eventSparseRead()
+{
+	ActiveEventSparse ev;
+	ActiveLockGuard guard(this->mutex, this->lockStats, "event sparse read");
+	if (!this->eventSparse)
+		return ev;
+	if (this->eventSparseLazyIs && this->eventSparseStale)
+	{
+		auto n = this->eventSparsePath.size();
+		if (n)
+		{
+			auto hr = this->eventSparsePool.get(n);
+			for (std::size_t i = 0; i < n; i++)						
+				hr->arr[i] = this->eventSparsePath[i];
+			this->eventSparse->state = hr;
+		}
+		this->eventSparseStale = false;
+	}
+	ev.id = this->eventSparse->id;
+	ev.state = this->eventSparse->state;
+	return ev;
 }
 
-inline void Alignment::Active::varPromote(SizeSizeUMap& mm, std::size_t& v)
+void Alignment::Active::varPromote(SizeSizeUMap& mm, std::size_t& v)
 {
 	auto x = v >> this->bits << this->bits;
 	auto it = mm.find(x);
@@ -111,6 +866,32 @@ std::size_t Alignment::Active::varDemote(const SizeSizeUMap& mm, std::size_t v)
 	return v;
 }
 
+void Alignment::Active::arenaCompact(bool force)
+{
+	if (!this->arena || !this->decomp)
+		return;
+	auto& dr = *this->decomp;
+	if (!force)
+	{
+		std::size_t live = 0;
+		for (auto& fs : dr.fuds)
+			for (auto& tr : fs.fud)
+			{
+				std::size_t sz = 1;
+				for (std::size_t i = 0; i < tr->dimension; i++)
+					sz *= tr->shape[i];
+				live += activeArenaTransformRepaSize(tr->dimension, sz);
+			}
+		if (this->arena->allocated <= 2 * live)
+			return;
+	}
+	auto arenaA = std::make_shared<ActiveArena>(this->arena->blockSize);
+	for (auto& fs : dr.fuds)
+		for (auto& tr : fs.fud)
+			tr = activeArenaTransformRepa(arenaA, *tr);
+	this->arena = arenaA;
+}
+
 std::size_t Alignment::Active::varMax() const
 {
 	std::size_t v = this->var;
@@ -135,31 +916,706 @@ std::size_t Alignment::Active::varComputedMax() const
     return (v << 12) + (8ull << 8) + 255 + (1ull << this->bits);
 }
 
-#define UNLOG ; log_str.flush(); this->log(*this, log_str.str());}
-#define LOG { std::ostringstream log_str; log_str << (this->name.size() ? this->name + "\t" : "") << 
-
-// event ids should be monotonic and updated no more than once
-bool Alignment::Active::update(ActiveUpdateParameters pp)
+// the underlying var values of the history event, with promotions, computed and sparse ancestors
+// if dynamicIs then use the event's own frames, otherwise the current frames
+void Alignment::Active::eventListVarValues(std::size_t historyEventA, bool dynamicIs, SizeUCharStructList& jj)
 {
-	auto drmul = listVarValuesDecompFudSlicedRepasPathSlice_u;
-
-	bool ok = true;
-	try 
+	auto& comp = this->induceVarComputeds;
+	auto& slpp = this->underlyingSlicesParent;
+	auto promote = this->underlyingOffsetIs;
+	auto& proms = this->underlyingsVarsOffset;		
+	std::size_t block1 = (std::size_t)1 << this->bits;
+	auto& frameUnderlyingsA = this->frameUnderlyings;
+	// no frames is equivalent to the current frame only
+	std::size_t frameUnderlyingsSize = std::max(frameUnderlyingsA.size(), (std::size_t)1);
+	std::size_t m = 0;
+	for (auto& hr : this->underlyingHistoryRepa)
+		m += 8*hr->dimension*frameUnderlyingsSize;
+	m += 50*this->underlyingHistorySparse.size()*frameUnderlyingsSize;
+	m += 50*this->frameHistorys.size();
+	jj.reserve(m);
+	auto z = this->historySize;
+	auto over = this->historyOverflow;
+	auto j = historyEventA;
+	for (std::size_t g = 0; g < frameUnderlyingsSize; g++)
 	{
-		std::size_t eventA = 0;
-		std::size_t historyEventA = 0;
-		std::size_t sliceA = 0;
-		bool continuousA = false;
-		std::lock_guard<std::mutex> guard(this->mutex);
-		if (ok)
-		{				
-			// check consistent underlying
-			if (ok)
+		std::size_t f = g < frameUnderlyingsA.size() ? frameUnderlyingsA[g] : 0;
+		if (dynamicIs && this->frameUnderlyingDynamicIs)
+		{
+			auto& frameUnderlyingsB = this->historyFrameUnderlying[j];
+			if (g < frameUnderlyingsB.size())
+				f = frameUnderlyingsB[g];
+			else
+				f = 0;
+		}
+		if (g && !f)
+			continue;
+		auto& mm = this->framesVarsOffset[g];
+		for (auto& hr : this->underlyingHistoryRepa)
+		{
+			auto n = hr->dimension;
+			auto vv = hr->vectorVar;
+			auto sh = hr->shape;
+			auto rr = hr->arr;	
+			for (std::size_t i = 0; i < n; i++)
 			{
-				ok = ok && this->historySize > 0;
-				for (auto& ev : this->underlyingEventsRepa)
-					ok = ok && ev && ev->state;
-				for (auto& ev : this->underlyingEventsSparse)
+				SizeUCharStruct qq;
+				qq.size = vv[i];
+				if (f <= j)
+					qq.uchar = rr[(j-f)*n + i];	
+				else if (f && over && z > f)
+					qq.uchar = rr[((j+z-f)%z)*n + i];	
+				else
+					qq.uchar = 0;
+				if (comp.count(qq.size)) // computed
+				{
+					std::size_t s = sh[i];
+					std::size_t b = 0; 
+					if (s)
+					{
+						s--;
+						while (s >> b)
+							b++;
+					}
+					qq.size = block1 + (qq.size << 12) + (b << 8) + qq.uchar;
+					qq.uchar = 1;
+					auto it = slpp.find(qq.size);
+					if (f)
+						this->varPromote(mm, qq.size);
+					jj.push_back(qq);
+					while (it != slpp.end() && it->second)
+					{
+						qq.size = it->second;
+						if (f)
+							this->varPromote(mm, qq.size);
+						jj.push_back(qq);
+						it = slpp.find(it->second);
+					}
+				}
+				else if (qq.uchar)
+				{
+					if (f)
+						this->varPromote(mm, qq.size);
+					jj.push_back(qq);
+				}
+			}							
+		}
+		std::size_t h = 0;									
+		for (auto& hr : this->underlyingHistorySparse)
+		{
+			std::size_t v = 0;
+			if (f <= j)
+				v = hr->arr[j-f];
+			else if (f && over && z > f)
+				v = hr->arr[(j+z-f)%z]; 
+			if (v)
+			{
+				{
+					SizeUCharStruct qq;
+					qq.uchar = 1;			
+					qq.size = v;
+					if (promote)
+						this->varPromote(proms[h], qq.size);
+					if (f)
+						this->varPromote(mm, qq.size);
+					jj.push_back(qq);
+				}								
+				auto it = slpp.find(v);
+				while (it != slpp.end())
+				{
+					SizeUCharStruct qq;
+					qq.uchar = 1;
+					qq.size = it->second;
+					if (!qq.size)
+						break;
+					if (promote)
+						this->varPromote(proms[h], qq.size);
+					if (f)
+						this->varPromote(mm, qq.size);
+					jj.push_back(qq);
+					it = slpp.find(it->second);
+				}										
+			}
+			h++;
+		}										
+	}
+	if (this->decomp && this->historySparse && this->frameHistorys.size())
+	{
+		auto& hr = this->historySparse;
+		auto& slpp = this->decomp->mapVarParent();
+		for (std::size_t g = 0; g < this->frameHistorys.size(); g++)
+		{
+			std::size_t f = this->frameHistorys[g];
+			if (dynamicIs && this->frameHistoryDynamicIs)
+			{
+				auto& frameHistorysB = this->historyFrameHistory[j];
+				if (g < frameHistorysB.size())
+					f = frameHistorysB[g];
+				else
+					f = 0;
+			}
+			if (!f)
+				continue;
+			auto& mm = this->framesVarsOffset[g];
+			std::size_t v = 0;
+			if (f <= j)
+				v = hr->arr[j-f];
+			else if (f && over && z > f)
+				v = hr->arr[(j+z-f)%z]; 
+			if (v)
+			{
+				{
+					SizeUCharStruct qq;
+					qq.uchar = 1;			
+					qq.size = v;
+					if (f)
+						this->varPromote(mm, qq.size);
+					jj.push_back(qq);
+				}								
+				auto it = slpp.find(v);
+				while (it != slpp.end())
+				{
+					SizeUCharStruct qq;
+					qq.uchar = 1;
+					qq.size = it->second;
+					if (!qq.size)
+						break;
+					if (f)
+						this->varPromote(mm, qq.size);
+					jj.push_back(qq);
+					it = slpp.find(it->second);
+				}										
+			}
+		}
+	}
+}
+
+bool Alignment::Active::varPromoteFind(const SizeSizeUMap& mm, std::size_t& v) const
+{
+	auto x = v >> this->bits << this->bits;
+	auto it = mm.find(x);
+	if (it == mm.end())
+		return false;
+	v += it->second;
+	return true;
+}
+
+// as eventListVarValues for the next event but with the current frame taken from event k of the given underlying
+// if historyIs the other underlying frames are taken from the history before historyEventA, otherwise from the earlier events of the given underlying
+// nothing is added to underlyingSlicesParent or the promotions, variables without a promotion are dropped
+// because the model cannot depend on them
+void Alignment::Active::classifyListVarValues(const HistoryRepaPtrList& hrs, const HistorySparseArrayPtrList& has, std::size_t k, bool historyIs, std::size_t historyEventA, SizeUCharStructList& jj) const
+{
+	auto& comp = this->induceVarComputeds;
+	auto& slpp = this->underlyingSlicesParent;
+	auto promote = this->underlyingOffsetIs;
+	auto& proms = this->underlyingsVarsOffset;		
+	std::size_t block1 = (std::size_t)1 << this->bits;
+	auto& frameUnderlyingsA = this->frameUnderlyings;
+	std::size_t frameUnderlyingsSize = std::max(frameUnderlyingsA.size(), (std::size_t)1);
+	auto z = this->historySize;
+	auto over = this->historyOverflow;
+	auto j = historyEventA;
+	SizeSizeUMap empty;
+	auto promotes = [&](const std::map<std::size_t, SizeSizeUMap>& mms, std::size_t g) -> const SizeSizeUMap&
+	{
+		auto it = mms.find(g);
+		return it != mms.end() ? it->second : empty;
+	};
+	auto push = [&](SizeUCharStruct qq, const SizeSizeUMap* pm, const SizeSizeUMap* mm)
+	{
+		if (pm && !this->varPromoteFind(*pm, qq.size))
+			return;
+		if (mm && !this->varPromoteFind(*mm, qq.size))
+			return;
+		jj.push_back(qq);
+	};
+	for (std::size_t g = 0; g < frameUnderlyingsSize; g++)
+	{
+		std::size_t f = g < frameUnderlyingsA.size() ? frameUnderlyingsA[g] : 0;
+		if (g && !f)
+			continue;
+		auto& mm = promotes(this->framesVarsOffset, g);
+		auto pf = f ? &mm : 0;
+		// the frame is in the given underlying at event kf if given
+		bool given = !f || !historyIs;
+		bool present = !given || f <= k;
+		std::size_t kf = present && given ? k-f : 0;
+		for (std::size_t h = 0; h < this->underlyingHistoryRepa.size(); h++)
+		{
+			auto& hr = this->underlyingHistoryRepa[h];
+			auto n = hr->dimension;
+			auto vv = hr->vectorVar;
+			auto sh = hr->shape;
+			auto& hr1 = *hrs[h];
+			auto n1 = hr1.dimension;
+			auto vv1 = hr1.vectorVar;
+			auto z1 = hr1.size;
+			bool equiv = n == n1;
+			for (std::size_t i = 0; equiv && i < n; i++)
+				equiv = equiv && vv[i] == vv1[i];
+			SizeSizeUMap mvv1;
+			if (given && !equiv)
+				for (std::size_t i = 0; i < n1; i++)
+					mvv1[vv1[i]] = i;
+			for (std::size_t i = 0; i < n; i++)
+			{
+				SizeUCharStruct qq;
+				qq.size = vv[i];
+				qq.uchar = 0;
+				if (given && present)
+				{
+					std::size_t i1 = i;
+					if (!equiv)
+					{
+						auto it = mvv1.find(qq.size);
+						i1 = it != mvv1.end() ? it->second : n1;
+					}
+					if (i1 < n1)
+						qq.uchar = hr1.evient ? hr1.arr[kf*n1 + i1] : hr1.arr[i1*z1 + kf];
+				}
+				else if (!given && f <= j)
+					qq.uchar = hr->arr[(j-f)*n + i];	
+				else if (!given && over && z > f)
+					qq.uchar = hr->arr[((j+z-f)%z)*n + i];	
+				if (comp.count(qq.size)) // computed
+				{
+					std::size_t s = sh[i];
+					std::size_t b = 0; 
+					if (s)
+					{
+						s--;
+						while (s >> b)
+							b++;
+					}
+					auto x = qq.uchar;
+					qq.uchar = 1;
+					qq.size = block1 + (vv[i] << 12) + (b << 8) + x;
+					push(qq, 0, pf);
+					for (int c = (int)(b-1); c > 0; c--)
+					{
+						qq.size = block1 + (vv[i] << 12) + (c << 8) + (x >> (b-c));
+						push(qq, 0, pf);
+					}
+				}
+				else if (qq.uchar)
+					push(qq, 0, pf);
+			}							
+		}
+		for (std::size_t h = 0; h < this->underlyingHistorySparse.size(); h++)
+		{
+			auto& hr = this->underlyingHistorySparse[h];
+			auto pm = promote ? &promotes(proms, h) : 0;
+			std::size_t v = 0;
+			int i1 = -1;
+			const std::size_t* rr1 = 0;
+			if (given && present && has[h])
+			{
+				auto c = has[h]->capacity;
+				rr1 = has[h]->arr + kf*c;
+				for (int i = (int)c-1; i >= 0 && !v; i--)
+					if (rr1[i])
+					{
+						v = rr1[i];
+						i1 = i;
+					}
+			}
+			else if (!given && f <= j)
+				v = hr->arr[j-f];
+			else if (!given && over && z > f)
+				v = hr->arr[(j+z-f)%z]; 
+			if (v)
+			{
+				SizeUCharStruct qq;
+				qq.uchar = 1;			
+				qq.size = v;
+				push(qq, pm, pf);
+				auto it = slpp.find(v);
+				if (it == slpp.end() && i1 > 0)
+				{
+					// a new sparse value whose ancestors are only in the event
+					for (int i = i1-1; i >= 0 && rr1[i]; i--)
+					{
+						qq.size = rr1[i];
+						push(qq, pm, pf);
+					}
+				}
+				while (it != slpp.end())
+				{
+					qq.size = it->second;
+					if (!qq.size)
+						break;
+					push(qq, pm, pf);
+					it = slpp.find(it->second);
+				}										
+			}
+		}										
+	}
+	if (historyIs && this->decomp && this->historySparse && this->frameHistorys.size())
+	{
+		auto& hr = this->historySparse;
+		auto& slpp = this->decomp->mapVarParent();
+		for (std::size_t g = 0; g < this->frameHistorys.size(); g++)
+		{
+			std::size_t f = this->frameHistorys[g];
+			if (!f)
+				continue;
+			auto& mm = promotes(this->framesVarsOffset, g);
+			std::size_t v = 0;
+			if (f <= j)
+				v = hr->arr[j-f];
+			else if (over && z > f)
+				v = hr->arr[(j+z-f)%z]; 
+			if (v)
+			{
+				SizeUCharStruct qq;
+				qq.uchar = 1;			
+				qq.size = v;
+				push(qq, 0, &mm);
+				auto it = slpp.find(v);
+				while (it != slpp.end())
+				{
+					qq.size = it->second;
+					if (!qq.size)
+						break;
+					push(qq, 0, &mm);
+					it = slpp.find(it->second);
+				}										
+			}
+		}
+	}
+}
+
+// copy the selected repa variables of the events from the evient underlying to a varient history
+// the selected variables are replaced by their frame promoted variables
+std::unique_ptr<HistoryRepa> Alignment::Active::varientHistoryRepa(const SizeList& eventsA, SizeSet& qqr)
+{
+	auto& llr = this->underlyingHistoryRepa;
+	SizeList frameUnderlyingsA(this->frameUnderlyings);
+	if (!frameUnderlyingsA.size())
+		frameUnderlyingsA.push_back(0);					
+	auto hrr = std::make_unique<HistoryRepa>();
+	hrr->dimension = qqr.size()*frameUnderlyingsA.size();
+	auto nr = hrr->dimension;
+	hrr->vectorVar = new std::size_t[nr];
+	auto vvr = hrr->vectorVar;
+	hrr->shape = new std::size_t[nr];
+	auto shr = hrr->shape;
+	hrr->size = eventsA.size();
+	auto zr = hrr->size;
+	hrr->evient = false;
+	hrr->arr = new unsigned char[zr*nr];
+	auto rrr = hrr->arr;		
+	auto ev = eventsA.data();
+	auto z = this->historySize;
+	auto over = this->historyOverflow;
+	std::size_t i = 0;
+	for (std::size_t g = 0; g < frameUnderlyingsA.size(); g++)
+	{
+		auto f = frameUnderlyingsA[g];
+		auto& mm = this->framesVarsOffset[g];
+		for (auto v : qqr)
+		{
+			vvr[i] = v;
+			if (g || f)
+				this->varPromote(mm, vvr[i]);
+			for (auto& hr : llr)
+			{
+				auto& mvv = hr->mapVarInt();
+				auto it = mvv.find(v);
+				if (it != mvv.end())
+				{
+					auto n = hr->dimension;
+					auto rr = hr->arr;
+					auto k = it->second;
+					shr[i] = hr->shape[k];
+					auto izr = i*zr;
+					for (std::size_t j = 0; j < zr; j++)
+					{
+						if (this->frameUnderlyingDynamicIs)
+						{
+							f = 0;
+							auto& frameUnderlyingsB = this->historyFrameUnderlying[ev[j]];
+							if (g < frameUnderlyingsB.size())
+								f = frameUnderlyingsB[g];
+						}
+						if (g && !f)
+							rrr[izr + j] = 0;					
+						else if (f <= ev[j])
+							rrr[izr + j] = rr[(ev[j]-f)*n + k];
+						else if (f && over && z > f)
+							rrr[izr + j] = rr[((ev[j]+z-f)%z)*n + k];
+						else
+							rrr[izr + j] = 0;					
+					}
+					break;
+				}
+			}
+			i++;
+		}
+	}
+	qqr.clear();
+	for (i = 0; i < nr; i++)
+		qqr.insert(vvr[i]);
+	return hrr;
+}
+
+// count the sparse variables and their ancestors and collect the descendants of each ancestor
+void Alignment::Active::sparseCountsDescendants(const HistorySparseArray& haa, const SizeSizeUMap& slppa, SizeSizeUMap& qqa, std::unordered_map<std::size_t, SizeSet>& mma) const
+{
+	if (!haa.size || !haa.capacity)
+		return;
+	auto za = haa.size; 
+	auto na = haa.capacity; 
+	auto raa = haa.arr;
+	qqa.reserve(slppa.size());
+	mma.reserve(slppa.size());
+	for (std::size_t k = 0; k < na; k++)
+	{
+		for (std::size_t j = 0; j < za; j++)
+		{
+			auto v = raa[j*na + k];
+			SizeList ll {v};
+			qqa[v]++;
+			auto it = slppa.find(v);
+			while (it != slppa.end())
+			{
+				ll.push_back(it->second);
+				qqa[it->second]++;
+				it = slppa.find(it->second);
+			}								
+			for (int i = (int)(ll.size()) - 1; i > 0; i--)
+				for (int m = i-1; m >= 0; m--)
+					mma[ll[i]].insert(ll[m]);
+		}
+	}
+}
+
+// create the slice transforms of the derived variables, one for each state with a non-zero count and
+// a remainder for the rest, each conditional on the parent slice if not the root
+void Alignment::Active::sliceTransforms(std::size_t sliceA, const SizeList& kk, const std::size_t* skk, const double* rr0, std::size_t sz, TransformRepaPtrList& ll, SizeList& sl)
+{
+	auto m = kk.size();
+	auto transform = [this](std::size_t n, std::size_t sz)
+	{
+		if (this->arena)
+			return activeArenaTransformRepa(this->arena, n, sz);
+		auto tr = std::make_shared<TransformRepa>();
+		tr->dimension = n;
+		tr->vectorVar = new std::size_t[n];
+		tr->shape = new std::size_t[n];
+		tr->arr = new unsigned char[sz];
+		return tr;
+	};
+	bool remainder = false;
+	for (std::size_t i = 0; i < sz; i++)
+	{
+		if (rr0[i] <= 0.0)
+		{
+			remainder = true;
+			continue;
+		}
+		TransformRepaPtr tr;
+		if (sliceA)
+		{
+			tr = transform(m + 1, 2 * sz);
+			auto ww = tr->vectorVar;
+			auto sh = tr->shape;
+			ww[0] = sliceA;
+			sh[0] = 2;
+			for (std::size_t j = 0; j < m; j++)
+			{
+				ww[j + 1] = kk[j];
+				sh[j + 1] = skk[j];
+			}
+			auto rr = tr->arr;
+			for (std::size_t j = 0; j < 2 * sz; j++)
+				rr[j] = 0;
+			rr[sz + i] = 1;
+		}
+		else
+		{
+			tr = transform(m, sz);
+			auto ww = tr->vectorVar;
+			auto sh = tr->shape;
+			for (std::size_t j = 0; j < m; j++)
+			{
+				ww[j] = kk[j];
+				sh[j] = skk[j];
+			}
+			auto rr = tr->arr;
+			for (std::size_t j = 0; j < sz; j++)
+				rr[j] = 0;
+			rr[i] = 1;
+		}
+		tr->valency = 2;						
+		auto w = this->varSlice;
+		this->varSlice++;
+		tr->derived = w;
+		sl.push_back(w);
+		ll.push_back(tr);
+	}
+	if (remainder)
+	{
+		TransformRepaPtr tr;
+		if (sliceA)
+		{
+			tr = transform(m + 1, 2 * sz);
+			auto ww = tr->vectorVar;
+			auto sh = tr->shape;
+			ww[0] = sliceA;
+			sh[0] = 2;
+			for (std::size_t j = 0; j < m; j++)
+			{
+				ww[j + 1] = kk[j];
+				sh[j + 1] = skk[j];
+			}
+			auto rr = tr->arr;
+			for (std::size_t j = 0; j < 2 * sz; j++)
+				rr[j] = j >= sz && rr0[j - sz] <= 0.0 ? 1 : 0;
+		}
+		else
+		{
+			tr = transform(m, sz);
+			auto ww = tr->vectorVar;
+			auto sh = tr->shape;
+			for (std::size_t j = 0; j < m; j++)
+			{
+				ww[j] = kk[j];
+				sh[j] = skk[j];
+			}
+			auto rr = tr->arr;
+			for (std::size_t j = 0; j < sz; j++)
+				rr[j] = rr0[j] <= 0.0 ? 1 : 0;
+		}
+		tr->valency = 2;
+		auto w = this->varSlice;
+		this->varSlice++;
+		tr->derived = w;
+		sl.push_back(w);
+		ll.push_back(tr);
+	}
+}
+
+// starting at the root fud, apply each fud's transforms in order and descend to the child slice that is set
+void Alignment::Active::eventPathSlice(const SizeUCharStructList& jj, std::size_t mapCapacity, ActiveVarValueMap& mm, SizeList& ll) const
+{
+	ll.clear();
+	auto& dr = *this->decomp;
+	auto& vi = dr.mapVarInt();
+	auto it = vi.find(0);
+	if (it == vi.end())
+		return;
+	mm.clear(std::max(mapCapacity, (std::size_t)1) * jj.size());
+	for (auto& qq : jj)
+		mm.assign(qq.size, qq.uchar);
+	while (it != vi.end())
+	{
+		auto& fs = dr.fuds[it->second];
+		for (auto& tr : fs.fud)
+		{
+			auto n = tr->dimension;
+			auto vv = tr->vectorVar;
+			auto sh = tr->shape;
+			std::size_t k = 0;
+			for (std::size_t i = 0; i < n; i++)
+				k = sh[i]*k + mm.at(vv[i]);
+			mm.assign(tr->derived, tr->arr[k]);
+		}
+		std::size_t v = 0;
+		auto it1 = this->sliceIndicators.find(fs.parent);
+		if (it1 != this->sliceIndicators.end())
+		{
+			auto& si = it1->second;
+			std::size_t k = 0;
+			for (std::size_t i = 0; i < si.vars.size(); i++)
+				k = si.shape[i]*k + mm.at(si.vars[i]);
+			auto it2 = si.indexChild.find(k);
+			v = it2 != si.indexChild.end() ? it2->second : si.remainder;
+			if (v)
+				mm.assign(v, 1);
+		}
+		else
+			for (auto w : fs.children)
+				if (mm.at(w))
+				{
+					v = w;
+					break;
+				}
+		if (!v)
+			break;
+		ll.push_back(v);
+		it = vi.find(v);
+	}
+}
+
+// per thread log formatting buffer which keeps its capacity between records
+struct ActiveLogBuffer : public std::streambuf
+{
+	std::string str;
+	int_type overflow(int_type c) override
+	{
+		if (c != traits_type::eof())
+			str.push_back((char)c);
+		return c;
+	}
+	std::streamsize xsputn(const char* s, std::streamsize n) override
+	{
+		str.append(s, (std::size_t)n);
+		return n;
+	}
+};
+
+struct ActiveLogStream
+{
+	ActiveLogStream() : out(&buf) {}
+	ActiveLogBuffer buf;
+	std::ostream out;
+};
+
+inline ActiveLogStream& activeLogStream()
+{
+	thread_local ActiveLogStream st;
+	st.buf.str.clear();
+	st.out.clear();
+	st.out.flags(std::ios_base::skipws | std::ios_base::dec);
+	st.out.precision(6);
+	return st;
+}
+
+void Alignment::Active::logPost(const std::string& str)
+{
+	if (activeForkChild)
+		return;
+	if (this->logQueue)
+		this->logQueue->push(*this, str);
+	else
+		this->log(*this, str);
+}
+
+#define UNLOG ; this->logPost(log_st.buf.str);}
+#define LOG { auto& log_st = activeLogStream(); auto& log_str = log_st.out; log_str << this->name << (this->name.size() ? "\t" : "") << 
+
+// event ids should be monotonic and updated no more than once
+bool Alignment::Active::update(ActiveUpdateParameters pp)
+{
+	bool ok = true;
+	try 
+	{
+		std::size_t eventA = 0;
+		std::size_t historyEventA = 0;
+		std::size_t sliceA = 0;
+		bool continuousA = false;
+		ActiveLockGuard guard(this->mutex, this->lockStats, "update");
+		if (ok)
+		{				
+			// check consistent underlying
+			if (ok)
+			{
+				ok = ok && this->historySize > 0;
+				for (auto& ev : this->underlyingEventsRepa)
+					ok = ok && ev && ev->state;
+				for (auto& ev : this->underlyingEventsSparse)
 					ok = ok && ev;
 				for (auto& hr : this->underlyingHistoryRepa)
 					ok = ok && hr && hr->size == this->historySize && hr->dimension > 0  && hr->evient;
@@ -181,18 +1637,23 @@ bool Alignment::Active::update(ActiveUpdateParameters pp)
 					eventA = std::max(eventA,ev->id);		
 				continuousA = eventA == this->underlyingEventUpdated + 1;				
 			}
+			// record the underlying events
+			if (ok && this->recorder)
+			{
+				this->recordUpdate();
+			}
 			// copy events to active history
 			if (ok)
 			{		
 				auto& comp = this->induceVarComputeds;
 				auto& slpp = this->underlyingSlicesParent;
 				std::size_t block1 = (std::size_t)1 << this->bits;
-				HistoryRepaPtrList hrs;
-				hrs.reserve(this->underlyingEventsRepa.size());
+				auto& hrs = this->updateHistoryRepas;
+				hrs.clear();
 				for (auto& ev : this->underlyingEventsRepa)
 					hrs.push_back(ev->state);
-				HistorySparseArrayPtrList has;
-				has.reserve(this->underlyingEventsSparse.size());		
+				auto& has = this->updateHistorySparses;
+				has.clear();
 				for (auto& ev : this->underlyingEventsSparse)
 					has.push_back(ev->state);
 				// check consistent historyEvent
@@ -218,6 +1679,9 @@ bool Alignment::Active::update(ActiveUpdateParameters pp)
 						LOG "update\terror: inconsistent underlying " UNLOG		
 					}
 				}
+				// remove the overwritten event from the counts of its slice
+				if (ok && this->induceCountsIs && this->historyOverflow && this->historySparse)
+					this->sliceCountsEvent(this->historySparse->arr[this->historyEvent], this->historyEvent, false);
 				for (std::size_t h = 0; ok && h < hrs.size(); h++)
 				{
 					auto& hr = *this->underlyingHistoryRepa[h];
@@ -350,172 +1814,13 @@ bool Alignment::Active::update(ActiveUpdateParameters pp)
 						LOG "update\terror: inconsistent history" UNLOG
 					}
 				}
-				SizeUCharStructList jj;
+				auto& jj = this->updateVarValues;
+				jj.clear();
 				if (ok)
-				{
-					auto& comp = this->induceVarComputeds;
-					auto& slpp = this->underlyingSlicesParent;						
-					auto promote = this->underlyingOffsetIs;
-					auto& proms = this->underlyingsVarsOffset;
-					std::size_t block1 = (std::size_t)1 << this->bits;
-					SizeList frameUnderlyingsA(this->frameUnderlyings);
-					if (!frameUnderlyingsA.size())
-						frameUnderlyingsA.push_back(0);	
-					std::size_t m = 0;
-					for (auto& hr : this->underlyingHistoryRepa)
-						m += 8*hr->dimension*frameUnderlyingsA.size();
-					m += 50*this->underlyingHistorySparse.size()*frameUnderlyingsA.size();
-					m += 50*this->frameHistorys.size();
-					jj.reserve(m);
-					auto z = this->historySize;
-					auto over = this->historyOverflow;
-					auto j = this->historyEvent;
-					for (std::size_t g = 0; g < frameUnderlyingsA.size(); g++)
-					{
-						auto f = frameUnderlyingsA[g];
-						if (g && !f)
-							continue;
-						auto& mm = this->framesVarsOffset[g];
-						for (auto& hr : this->underlyingHistoryRepa)
-						{
-							auto n = hr->dimension;
-							auto vv = hr->vectorVar;
-							auto sh = hr->shape;
-							auto rr = hr->arr;	
-							for (std::size_t i = 0; i < n; i++)
-							{
-								SizeUCharStruct qq;
-								qq.size = vv[i];
-								if (f <= j)
-									qq.uchar = rr[(j-f)*n + i];	
-								else if (f && over && z > f)
-									qq.uchar = rr[((j+z-f)%z)*n + i];	
-								else
-									qq.uchar = 0;
-								if (comp.count(qq.size)) // computed
-								{
-									std::size_t s = sh[i];
-									std::size_t b = 0; 
-									if (s)
-									{
-										s--;
-										while (s >> b)
-											b++;
-									}
-									qq.size = block1 + (qq.size << 12) + (b << 8) + qq.uchar;
-									qq.uchar = 1;
-									auto it = slpp.find(qq.size);
-									if (f)
-										this->varPromote(mm, qq.size);
-									jj.push_back(qq);
-									while (it != slpp.end() && it->second)
-									{
-										qq.size = it->second;
-										if (f)
-											this->varPromote(mm, qq.size);
-										jj.push_back(qq);
-										it = slpp.find(it->second);
-									}
-								}
-								else if (qq.uchar)
-								{
-									if (f)
-										this->varPromote(mm, qq.size);
-									jj.push_back(qq);
-								}
-							}
-						}
-						std::size_t h = 0;
-						for (auto& hr : this->underlyingHistorySparse)
-						{
-							std::size_t v = 0;
-							if (f <= j)
-								v = hr->arr[j-f];
-							else if (f && over && z > f)
-								v = hr->arr[(j+z-f)%z]; 
-							if (v)
-							{
-								{
-									SizeUCharStruct qq;
-									qq.uchar = 1;			
-									qq.size = v;
-									if (promote)
-										this->varPromote(proms[h], qq.size);
-									if (f)
-										this->varPromote(mm, qq.size);
-									jj.push_back(qq);
-								}								
-								auto it = slpp.find(v);
-								while (it != slpp.end())
-								{
-									SizeUCharStruct qq;
-									qq.uchar = 1;
-									qq.size = it->second;
-									if (!qq.size)
-										break;
-									if (promote)
-										this->varPromote(proms[h], qq.size);
-									if (f)
-										this->varPromote(mm, qq.size);
-									jj.push_back(qq);
-									it = slpp.find(it->second);
-								}										
-							}
-							h++;
-						}										
-					}
-					if (ok && this->decomp && this->historySparse && this->frameHistorys.size())
-					{
-						auto& hr = this->historySparse;
-						auto& slpp = this->decomp->mapVarParent();
-						for (std::size_t g = 0; g < this->frameHistorys.size(); g++)
-						{
-							auto f = this->frameHistorys[g];
-							if (!f)
-								continue;
-							auto& mm = this->framesVarsOffset[g];
-							std::size_t v = 0;
-							if (f <= j)
-								v = hr->arr[j-f];
-							else if (f && over && z > f)
-								v = hr->arr[(j+z-f)%z]; 
-							if (v)
-							{
-								{
-									SizeUCharStruct qq;
-									qq.uchar = 1;			
-									qq.size = v;
-									if (f)
-										this->varPromote(mm, qq.size);			
-									jj.push_back(qq);
-								}								
-								auto it = slpp.find(v);
-								while (it != slpp.end())
-								{
-									SizeUCharStruct qq;
-									qq.uchar = 1;
-									qq.size = it->second;
-									if (!qq.size)
-										break;										
-									if (f)
-										this->varPromote(mm, qq.size);			
-									jj.push_back(qq);
-									it = slpp.find(it->second);
-								}										
-							}
-						}
-					}
-				}
-				std::unique_ptr<SizeList> ll;
+					this->eventListVarValues(this->historyEvent, false, jj);
+				auto ll = &this->updatePath;
 				if (ok)
-				{
-					ll = drmul(jj,*this->decomp,(unsigned char)(pp.mapCapacity));	
-					ok = ok && ll;
-					if (!ok)
-					{
-						LOG "update\terror: drmul failed to return a list" UNLOG
-					}						
-				}
+					this->eventPathSlice(jj, pp.mapCapacity, this->updateVarValueMap, *ll);
 				// sync active slices
 				if (ok && this->historySparse)
 				{
@@ -526,14 +1831,20 @@ bool Alignment::Active::update(ActiveUpdateParameters pp)
 					if (!this->historyOverflow || sliceA != sliceB)
 					{
 						this->historySparse->arr[this->historyEvent] = sliceA;
+						// move the event's set node from the previous slice to the new slice
+						SizeSet::node_type node;
+						if (this->historyOverflow)
+							node = this->historySlicesSetEvent[sliceB].extract(this->historyEvent);
 						auto& setA = this->historySlicesSetEvent[sliceA];
-						setA.insert(this->historyEvent);
+						if (node)
+							setA.insert(std::move(node));
+						else
+							setA.insert(this->historyEvent);
 						if (this->induceThreshold && setA.size() == this->induceThreshold)
 							this->induceSlices.insert(sliceA);
 						if (this->historyOverflow)
 						{
 							auto& setB = this->historySlicesSetEvent[sliceB];
-							setB.erase(this->historyEvent);
 							if (this->induceThreshold && setB.size() == this->induceThreshold-1)
 							{
 								this->induceSlices.erase(sliceB);
@@ -543,6 +1854,16 @@ bool Alignment::Active::update(ActiveUpdateParameters pp)
 								this->historySlicesSetEvent.erase(sliceB);
 						}
 					}	
+					// update the samples of the slices
+					if (this->induceSampleSize)
+					{
+						if (this->historyOverflow)
+							this->sampleRemove(sliceB, this->historyEvent);
+						this->sampleInsert(sliceA, this->historyEvent);
+					}
+					// update the counts of the slice
+					if (this->induceCountsIs)
+						this->sliceCountsEvent(sliceA, this->historyEvent, true);
 					// handle next transition
 					if (this->historySliceCachingIs && !this->historySliceCumulativeIs 
 						&& this->historyOverflow && this->continousIs)
@@ -570,6 +1891,8 @@ bool Alignment::Active::update(ActiveUpdateParameters pp)
 									if (!prevs[sliceC].size())
 										prevs.erase(sliceC);
 								}
+								if (this->transitionIndexIs)
+									this->transitionIndex.decrement(sliceB, sliceC);
 							}
 						}
 					}
@@ -637,6 +1960,8 @@ bool Alignment::Active::update(ActiveUpdateParameters pp)
 							{
 								nexts[sliceC][sliceA]++;
 								prevs[sliceA].insert(sliceC);
+								if (this->transitionIndexIs)
+									this->transitionIndex.increment(sliceC, sliceA);
 							}
 						}
 					}
@@ -647,16 +1972,20 @@ bool Alignment::Active::update(ActiveUpdateParameters pp)
 					auto& ev = this->eventSparse;
 					ev->id = eventA;
 					std::size_t n = ll->size();
-					if (n)
+					// release the previous state so that the pool can reuse it if no consumer holds it
+					ev->state.reset();
+					if (this->eventSparseLazyIs)
+					{
+						this->eventSparsePath.assign(ll->begin(), ll->end());
+						this->eventSparseStale = true;
+					}
+					else if (n)
 					{
-						auto hr = std::make_shared<HistorySparseArray>(1,n);
-						auto rr = hr->arr;	
+						ev->state = this->eventSparsePool.get(n);
+						auto rr = ev->state->arr;	
 						for (std::size_t i = 0; i < n; i++)						
 							rr[i] = (*ll)[i];
-						ev->state = hr;
 					}
-					else 
-						ev->state.reset();
 				}
 				if (ok && this->logging)
 				{
@@ -716,23 +2045,176 @@ void run_induce(Active& active, std::size_t sliceA, ActiveInduceParameters pp, A
 	return;
 };
 
-bool Alignment::Active::induce(ActiveInduceParameters pp, ActiveUpdateParameters ppu)
-{		
+bool Alignment::Active::classify(const std::vector<ActiveEventRepaPtr>& eventsRepa, const std::vector<ActiveEventSparsePtr>& eventsSparse, SizeList& ll, std::size_t mapCapacity)
+{
 	bool ok = true;
-	
 	try 
 	{
-		if (!pp.asyncThreadMax) // run synchronously
+		static thread_local HistoryRepaPtrList hrs;
+		static thread_local HistorySparseArrayPtrList has;
+		static thread_local SizeUCharStructList jj;
+		static thread_local ActiveVarValueMap mm;
+		ll.clear();
+		ActiveLockGuard guard(this->mutex, this->lockStats, "classify", true, true);
+		ok = ok && this->decomp;
+		ok = ok && eventsRepa.size() == this->underlyingHistoryRepa.size();
+		ok = ok && eventsSparse.size() == this->underlyingHistorySparse.size();
+		for (auto& ev : eventsRepa)
+			ok = ok && ev && ev->state && ev->state->size == 1;
+		for (auto& ev : eventsSparse)
+			ok = ok && (!ev || !ev->state || ev->state->size == 1);
+		for (auto& hr : this->underlyingHistoryRepa)
+			ok = ok && hr && hr->size == this->historySize && hr->evient;
+		if (!ok)
 		{
-			while (ok && !this->terminate)
-			{
-				std::size_t sliceA = 0;
-				std::size_t sliceSizeA = 0;	
-				for (auto sliceB : this->induceSlices)
-				{
-					auto sliceSizeB = this->historySlicesSetEvent[sliceB].size();
-					if (sliceSizeB > sliceSizeA)
-					{
+			LOG "classify\terror: inconsistent underlying or no decomp set" UNLOG
+		}
+		if (ok)
+		{
+			hrs.clear();
+			for (auto& ev : eventsRepa)
+				hrs.push_back(ev->state);
+			has.clear();
+			for (auto& ev : eventsSparse)
+				has.push_back(ev ? ev->state : HistorySparseArrayPtr());
+			jj.clear();
+			this->classifyListVarValues(hrs, has, 0, true, this->historyEvent, jj);
+			this->eventPathSlice(jj, mapCapacity, mm, ll);
+			hrs.clear();
+			has.clear();
+		}
+	}
+	catch (const std::exception& e) 
+	{
+		LOG "classify error: " << e.what() UNLOG
+		ok = false;
+	}
+	return ok;
+}
+
+// the batch is evaluated against a copy of the model and the variable maps taken under a shared lock
+// so that the active may be updated and induced while the threads run
+bool Alignment::Active::classifyBatch(const HistoryRepaPtrList& hrs, const HistorySparseArrayPtrList& has, SizeList& slices, SizeListList* paths, std::size_t threadsSize, std::size_t mapCapacity)
+{
+	bool ok = true;
+	try 
+	{
+		auto mark = clk::now();
+		slices.clear();
+		if (paths)
+			paths->clear();
+		std::size_t z = 0;
+		Active snap;
+		{
+			ActiveLockGuard guard(this->mutex, this->lockStats, "classify batch", true, true);
+			ok = ok && this->decomp;
+			ok = ok && hrs.size() == this->underlyingHistoryRepa.size();
+			ok = ok && has.size() == this->underlyingHistorySparse.size();
+			for (auto& hr : hrs)
+			{
+				ok = ok && hr && (!z || hr->size == z);
+				if (ok)
+					z = hr->size;
+			}
+			for (auto& hr : has)
+			{
+				ok = ok && (!hr || !z || hr->size == z);
+				if (ok && hr)
+					z = hr->size;
+			}
+			if (!ok)
+			{
+				LOG "classify batch\terror: inconsistent underlying or no decomp set" UNLOG
+			}
+			if (ok)
+			{
+				snap.system = this->system;
+				snap.bits = this->bits;
+				snap.induceVarComputeds = this->induceVarComputeds;
+				snap.underlyingSlicesParent = this->underlyingSlicesParent;
+				snap.underlyingOffsetIs = this->underlyingOffsetIs;
+				snap.underlyingsVarsOffset = this->underlyingsVarsOffset;
+				snap.frameUnderlyings = this->frameUnderlyings;
+				snap.framesVarsOffset = this->framesVarsOffset;
+				snap.underlyingHistoryRepa = this->underlyingHistoryRepa;
+				snap.underlyingHistorySparse = this->underlyingHistorySparse;
+				auto dr = std::make_shared<DecompFudSlicedRepa>();
+				dr->fuds = this->decomp->fuds;
+				dr->fudRepasSize = this->decomp->fudRepasSize;
+				dr->mapVarInt();
+				dr->mapVarParent();
+				snap.decomp = dr;
+				snap.sliceIndicatorIs = this->sliceIndicatorIs;
+				snap.sliceIndicators = this->sliceIndicators;
+			}
+		}
+		if (ok && z)
+		{
+			slices.resize(z);
+			if (paths)
+				paths->resize(z);
+			std::size_t t = threadsSize ? threadsSize : std::max((std::size_t)std::thread::hardware_concurrency(), (std::size_t)1);
+			t = std::min(t, z);
+			std::size_t chunk = (z + t - 1) / t;
+			auto run = [&](std::size_t k0, std::size_t k1)
+			{
+				SizeUCharStructList jj;
+				ActiveVarValueMap mm;
+				SizeList ll;
+				for (std::size_t k = k0; k < k1; k++)
+				{
+					jj.clear();
+					snap.classifyListVarValues(hrs, has, k, false, 0, jj);
+					snap.eventPathSlice(jj, mapCapacity, mm, ll);
+					slices[k] = ll.size() ? ll.back() : 0;
+					if (paths)
+						(*paths)[k] = ll;
+				}
+			};
+			std::vector<std::thread> threads;
+			threads.reserve(t);
+			for (std::size_t k0 = chunk; k0 < z; k0 += chunk)
+				threads.push_back(std::thread(run, k0, std::min(k0 + chunk, z)));
+			run(0, std::min(chunk, z));
+			for (auto& th : threads)
+				th.join();
+		}
+		if (ok && this->logging)
+		{
+			LOG "classify batch\tevents: " << z << "\ttime: " << ((sec)(clk::now() - mark)).count() << "s" UNLOG
+		}
+	}
+	catch (const std::exception& e) 
+	{
+		LOG "classify batch error: " << e.what() UNLOG
+		ok = false;
+	}
+	return ok;
+}
+
+bool Alignment::Active::induce(ActiveInduceParameters pp, ActiveUpdateParameters ppu)
+{		
+	bool ok = true;
+	
+	try 
+	{
+		// check parameters
+		if (ok && pp.forkIs && pp.timeMax <= 0.0)
+		{
+			ok = false;
+			LOG "induce\terror: forkIs requires timeMax" UNLOG
+		}
+		if (ok && !pp.asyncThreadMax) // run synchronously
+		{
+			while (ok && !this->terminate)
+			{
+				std::size_t sliceA = 0;
+				std::size_t sliceSizeA = 0;	
+				for (auto sliceB : this->induceSlices)
+				{
+					auto sliceSizeB = this->historySlicesSetEvent[sliceB].size();
+					if (sliceSizeB > sliceSizeA)
+					{
 						auto it = this->induceSliceFailsSize.find(sliceB);
 						if (it == this->induceSliceFailsSize.end() 
 							|| (it->second < sliceSizeB 
@@ -759,7 +2241,7 @@ bool Alignment::Active::induce(ActiveInduceParameters pp, ActiveUpdateParameters
 				{
 					SizeSet inducingSlicesA;
 					{
-						std::lock_guard<std::mutex> guard(this->mutex);		
+						ActiveLockGuard guard(this->mutex, this->lockStats, "induce scheduler", true, true);		
 						inducingSlicesA = this->inducingSlices;
 					}
 					SizeSet threadSlicesA;		
@@ -778,33 +2260,37 @@ bool Alignment::Active::induce(ActiveInduceParameters pp, ActiveUpdateParameters
 				{
 					std::size_t sliceA = 0;
 					std::size_t sliceSizeA = 0;	
-					for (auto sliceB : this->induceSlices)
 					{
-						if (pp.asyncUpdateLimit || !threads.count(sliceB))
+						ActiveLockGuard guard(this->mutex, this->lockStats, "induce scheduler", true, true);		
+						for (auto sliceB : this->induceSlices)
 						{
-							auto sliceSizeB = this->historySlicesSetEvent[sliceB].size();
-							if (sliceSizeB > sliceSizeA)
+							if (pp.asyncUpdateLimit || !threads.count(sliceB))
 							{
-								auto it = this->induceSliceFailsSize.find(sliceB);
-								if (it == this->induceSliceFailsSize.end() 
-									|| (it->second < sliceSizeB 
-										&& pp.induceThresholdExceeded(it->second, sliceSizeB)))
+								auto slicesIt = this->historySlicesSetEvent.find(sliceB);
+								auto sliceSizeB = slicesIt != this->historySlicesSetEvent.end() ? slicesIt->second.size() : 0;
+								if (sliceSizeB > sliceSizeA)
 								{
-									if (!threads.count(sliceB))
+									auto it = this->induceSliceFailsSize.find(sliceB);
+									if (it == this->induceSliceFailsSize.end() 
+										|| (it->second < sliceSizeB 
+											&& pp.induceThresholdExceeded(it->second, sliceSizeB)))
 									{
-										sliceA = sliceB;
-										sliceSizeA = sliceSizeB;				
+										if (!threads.count(sliceB) && !this->inducingSlices.count(sliceB))
+										{
+											sliceA = sliceB;
+											sliceSizeA = sliceSizeB;				
+										}
+										if (sliceSizeB > sliceSizeMax)
+											sliceSizeMax = sliceSizeB;
 									}
-									if (sliceSizeB > sliceSizeMax)
-										sliceSizeMax = sliceSizeB;
 								}
 							}
-						}
-					}	
+						}	
+					}
 					if (ok && sliceSizeA) 
 					{
 						{
-							std::lock_guard<std::mutex> guard(this->mutex);		
+							ActiveLockGuard guard(this->mutex, this->lockStats, "induce scheduler");		
 							this->inducingSlices.insert(sliceA);
 						}
 						threads.insert_or_assign(sliceA,std::thread(run_induce, std::ref(*this), sliceA, pp, ppu));
@@ -854,26 +2340,145 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 	auto llfr = setVariablesListTransformRepasFudRepa_u;
 	auto frmul = historyRepasFudRepasMultiply_up;
 	auto frdep = fudRepasSetVarsDepends;
-	auto drmul = listVarValuesDecompFudSlicedRepasPathSlice_u;
 	auto layerer = parametersLayererMaxRollByMExcludedSelfHighestLogIORepa_up;
 		
 	bool ok = true;
+	auto markInduce = clk::now();
+	// a forked child does the copy and the model and sends them to the parent, it never returns
+	bool forkChild = false;
+#ifdef __linux__
+	int forkPipe[2] = {-1, -1};
+	pid_t forkPid = -1;
+#endif
 	try 
 	{
+		// check parameters
+		if (ok && pp.forkIs && pp.timeMax <= 0.0)
+		{
+			ok = false;
+			LOG "induce\tslice: " << std::hex << sliceA << std::dec << "\terror: forkIs requires timeMax" UNLOG
+		}
 		if (ok && !this->terminate)
 		{
 			std::size_t varA = 0;
+			std::size_t historyGenerationA = 0;
 			std::size_t sliceSizeA = 0;	
+			std::size_t sampleSizeA = 0;	
+			ActiveSliceCounts countsA;
+			bool countsIs = false;
 			SizeList eventsA;			
 			std::unique_ptr<HistoryRepa> hrr;
 			std::unique_ptr<HistorySparseArray> haa;
 			SizeSet qqr;
 			SizeSizeUMap slppa;
+			bool fail = false;
+			bool cancelledA = false;
+			auto cancelled = [&]()
+			{
+				return (pp.cancel && pp.cancel->load()) 
+					|| (pp.timeMax > 0.0 && ((sec)(clk::now() - markInduce)).count() > pp.timeMax);
+			};
+			bool forked = false;
+#ifdef __linux__
+			// if snapshotIs the child's first byte is set only if no writer held the lock at the fork, so that its copy
+			// of the active is consistent, if guardA is given the child does not release it
+			auto forkStart = [&](bool snapshotIs, ActiveLockGuard* guardA)
+			{
+				if (pipe(forkPipe) != 0)
+				{
+					LOG "induce\tslice: " << std::hex << sliceA << std::dec << "\twarning: pipe failed, inducing in process" UNLOG
+					return;
+				}
+				forkPid = fork();
+				if (!forkPid)
+				{
+					activeForkChild = true;
+					forkChild = true;
+					if (guardA)
+						guardA->lockIs = false;
+					this->logging = false;
+					activeForkCloseDescriptors(forkPipe[1]);
+					unsigned char snapshot = !snapshotIs || !this->mutex.writer;
+					if (write(forkPipe[1], &snapshot, 1) != 1 || !snapshot)
+						_exit(1);
+					return;
+				}
+				close(forkPipe[1]);
+				if (forkPid < 0)
+				{
+					close(forkPipe[0]);
+					LOG "induce\tslice: " << std::hex << sliceA << std::dec << "\twarning: fork failed, inducing in process" UNLOG
+				}
+				else
+					forked = true;
+			};
+			// read up to n bytes from the child, killing it if the induction is cancelled or the active terminated
+			std::string forkStr;
+			bool forkKilled = false;
+			auto forkRead = [&](std::size_t n)
+			{
+				char buf[65536];
+				while (forkStr.size() < n)
+				{
+					if (!forkKilled && (this->terminate || cancelled()))
+					{
+						kill(forkPid, SIGKILL);
+						forkKilled = true;
+					}
+					struct pollfd pfd = {forkPipe[0], POLLIN, 0};
+					if (poll(&pfd, 1, 100) <= 0)
+						continue;
+					auto k = read(forkPipe[0], buf, std::min(sizeof(buf), n - forkStr.size()));
+					if (k <= 0)
+						break;
+					forkStr.append(buf, k);
+				}
+			};
+			auto forkStop = [&]()
+			{
+				close(forkPipe[0]);
+				int status = 0;
+				waitpid(forkPid, &status, 0);
+				forkPid = -1;
+				forked = false;
+				return status;
+			};
+			// fork before the copy, outside the lock, if the copy neither promotes variables nor reads frames other 
+			// than the current frame, so that the child copies from its own snapshot of the active
+			bool forkCopyIs = false;
+			if (ok && pp.forkIs)
+			{
+				{
+					ActiveLockGuard guard(this->mutex, this->lockStats, "induce fork", true, true);
+					historyGenerationA = this->historyGeneration;
+					auto it = this->historySlicesSetEvent.find(sliceA);
+					sliceSizeA = it != this->historySlicesSetEvent.end() ? it->second.size() : 0;
+					forkCopyIs = !this->underlyingOffsetIs && !this->frameUnderlyingDynamicIs
+						&& (!this->frameUnderlyings.size() || (this->frameUnderlyings.size() == 1 && !this->frameUnderlyings[0]))
+						&& !(this->decomp && this->historySparse && this->frameHistorys.size());
+				}
+				if (forkCopyIs)
+					forkStart(true, 0);
+				if (forked)
+				{
+					forkRead(1);
+					// a writer held the lock at the fork, so fork again under the shared lock
+					if (!forkKilled && !(forkStr.size() && forkStr[0]))
+					{
+						forkStop();
+						forkStr.clear();
+						ActiveLockGuard guard(this->mutex, this->lockStats, "induce fork", true, true);
+						historyGenerationA = this->historyGeneration;
+						forkStart(true, &guard);
+					}
+				}
+			}
+#endif
 			// copy repa and sparse from locked active
-			if (ok)
+			if (ok && !forked)
 			{			
 				auto mark = (ok && this->logging) ? clk::now() : std::chrono::time_point<clk>();
-				std::lock_guard<std::mutex> guard(this->mutex);		
+				ActiveLockGuard guard(this->mutex, this->lockStats, "induce copy", !forkChild);		
 				auto& llr = this->underlyingHistoryRepa;
 				auto& lla = this->underlyingHistorySparse;
 				// check consistent underlying
@@ -900,11 +2505,36 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 				if (ok)
 				{
 					varA = this->var;
+					historyGenerationA = this->historyGeneration;
 					auto& setEventsA = this->historySlicesSetEvent[sliceA];
-					eventsA.insert(eventsA.end(),setEventsA.begin(),setEventsA.end());
+					if (this->induceSampleSize && sliceSizeA > this->induceSampleSize)
+					{
+						// top up a sample depleted by events leaving the slice
+						auto it = this->historySlicesSample.find(sliceA);
+						if (it == this->historySlicesSample.end() || it->second.size() < this->induceSampleSize)
+							this->sampleSlice(sliceA);
+						auto& ll = this->historySlicesSample[sliceA];
+						eventsA.insert(eventsA.end(),ll.begin(),ll.end());
+						std::sort(eventsA.begin(), eventsA.end());
+					}
+					else
+						eventsA.insert(eventsA.end(),setEventsA.begin(),setEventsA.end());
+					sampleSizeA = eventsA.size();
 					SizeList frameUnderlyingsA(this->frameUnderlyings);
 					if (!frameUnderlyingsA.size())
 						frameUnderlyingsA.push_back(0);					
+					// take the slice counts if the whole slice is copied and there are no frames other than the current frame
+					if (this->induceCountsIs && sampleSizeA == sliceSizeA 
+						&& frameUnderlyingsA.size() == 1 && !frameUnderlyingsA[0] && !this->frameUnderlyingDynamicIs
+						&& !(this->decomp && this->historySparse && this->frameHistorys.size()))
+					{
+						auto it = this->historySlicesCounts.find(sliceA);
+						if (it != this->historySlicesCounts.end() && it->second.size == sliceSizeA)
+						{
+							countsA = it->second;
+							countsIs = true;
+						}
+					}
 					SizeSet qqc;
 					if (ok && llr.size())
 					{
@@ -927,72 +2557,34 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 							}
 						}
 					}
-					if (ok && qqr.size())
+					// with the counts, only the repa variables that can be among the top nmax by entropy are copied
+					if (ok && countsIs && qqr.size())
 					{
-						hrr = std::make_unique<HistoryRepa>();
-						hrr->dimension = qqr.size()*frameUnderlyingsA.size();
-						auto nr = hrr->dimension;
-						hrr->vectorVar = new std::size_t[nr];
-						auto vvr = hrr->vectorVar;
-						hrr->shape = new std::size_t[nr];
-						auto shr = hrr->shape;
-						hrr->size = eventsA.size();
-						auto zr = hrr->size;
-						hrr->evient = false;
-						hrr->arr = new unsigned char[zr*nr];
-						auto rrr = hrr->arr;		
-						auto ev = eventsA.data();
-						auto z = this->historySize;
-						auto over = this->historyOverflow;
-						std::size_t i = 0;
-						for (std::size_t g = 0; g < frameUnderlyingsA.size(); g++)
+						auto nmax = (std::size_t)std::sqrt(pp.znnmax / (double)(2*sampleSizeA));
+						nmax = std::max(nmax, pp.bmax);
+						double f = 1.0/(double)sampleSizeA;
+						DoubleSizePairList ee;
+						ee.reserve(qqr.size());
+						for (auto v : qqr)
 						{
-							auto f = frameUnderlyingsA[g];
-							auto& mm = this->framesVarsOffset[g];
-							for (auto v : qqr)
-							{
-								vvr[i] = v;
-								if (g || f)
-									this->varPromote(mm, vvr[i]);
-								for (auto& hr : llr)
-								{
-									auto& mvv = hr->mapVarInt();
-									auto it = mvv.find(v);
-									if (it != mvv.end())
-									{
-										auto n = hr->dimension;
-										auto rr = hr->arr;
-										auto k = it->second;
-										shr[i] = hr->shape[k];
-										auto izr = i*zr;
-										for (std::size_t j = 0; j < zr; j++)
-										{
-											if (this->frameUnderlyingDynamicIs)
-											{
-												f = 0;
-												auto& frameUnderlyingsB = this->historyFrameUnderlying[ev[j]];
-												if (g < frameUnderlyingsB.size())
-													f = frameUnderlyingsB[g];
-											}
-											if (g && !f)
-												rrr[izr + j] = 0;					
-											else if (f <= ev[j])
-												rrr[izr + j] = rr[(ev[j]-f)*n + k];
-											else if (f && over && z > f)
-												rrr[izr + j] = rr[((ev[j]+z-f)%z)*n + k];
-											else
-												rrr[izr + j] = 0;					
-										}
-										break;
-									}
-								}
-								i++;
-							}
+							auto it = countsA.repa.find(v);
+							if (it == countsA.repa.end())
+								continue;
+							double e = sliceCountsEntropy(it->second, f);
+							if (e > repaRounding)
+								ee.push_back(DoubleSizePair(-e,v));
+						}
+						if (ee.size() > nmax)
+						{
+							std::nth_element(ee.begin(), ee.begin() + nmax, ee.end());
+							ee.resize(nmax);
 						}
 						qqr.clear();
-						for (i = 0; i < nr; i++)
-							qqr.insert(vvr[i]);
+						for (auto& p : ee)
+							qqr.insert(p.second);
 					}
+					if (ok && qqr.size())
+						hrr = this->varientHistoryRepa(eventsA, qqr);
 					if (ok && (lla.size() || qqc.size() || (this->decomp && this->historySparse && this->frameHistorys.size())))
 					{
 						auto za = eventsA.size(); 
@@ -1194,17 +2786,28 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 				}	
 			}
 			// check consistent copy
-			if (ok)
+			if (ok && !forked)
 			{
 				ok = ok && (hrr || haa);
-				ok = ok && (!hrr || (hrr->dimension > 0 && hrr->size == sliceSizeA && hrr->arr));
-				ok = ok && (!haa || (haa->capacity > 0 && haa->size == sliceSizeA && haa->arr));
+				ok = ok && (!hrr || (hrr->dimension > 0 && hrr->size == sampleSizeA && hrr->arr));
+				ok = ok && (!haa || (haa->capacity > 0 && haa->size == sampleSizeA && haa->arr));
 				if (!ok)
 				{
 					LOG "induce\tslice: " << std::hex << sliceA << std::dec << "\terror: inconsistent copy" UNLOG
 				}	
 			}
-			bool fail = false;
+#ifdef __linux__
+			// otherwise fork after the copy, the child then uses only the copy
+			if (ok && pp.forkIs && !forkCopyIs && !forkChild)
+				forkStart(false, 0);
+#endif
+			// the threads of a forked child are not in a multithreaded process
+			auto tint = forkChild ? (std::size_t)1 : pp.tint;
+			if (ok && !forked && cancelled())
+			{
+				fail = true;
+				cancelledA = true;
+			}
 			std::unique_ptr<HistoryRepa> hr;
 			std::unique_ptr<FudRepa> fr;
 			std::size_t frSize = 0;
@@ -1212,48 +2815,51 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 			double algn = 0.0;
 			double diagonal = 0.0;
 			// induce model while unlocked
-			if (ok)
+			if (ok && !fail && !forked)
 			{
 				auto mark = (ok && this->logging) ? clk::now() : std::chrono::time_point<clk>();
 				SizeSizeUMap qqa;
 				std::unordered_map<std::size_t, SizeSet> mma;
 				// prepare for the sparse entropy calculations
-				if (ok && haa && haa->size && haa->capacity)
+				if (ok && countsIs && haa && haa->size && haa->capacity)
 				{
-					auto za = haa->size; 
-					auto na = haa->capacity; 
-					auto raa = haa->arr;
-					qqa.reserve(slppa.size());
+					qqa.reserve(countsA.sparse.size());
 					mma.reserve(slppa.size());
-					for (std::size_t k = 0; k < na; k++)
+					for (auto p : countsA.sparse)
 					{
-						for (std::size_t j = 0; j < za; j++)
+						qqa.insert(p);
+						auto it = slppa.find(p.first);
+						while (it != slppa.end())
 						{
-							auto v = raa[j*na + k];
-							SizeList ll {v};
-							qqa[v]++;
-							auto it = slppa.find(v);
-							while (it != slppa.end())
-							{
-								ll.push_back(it->second);
-								qqa[it->second]++;
-								it = slppa.find(it->second);
-							}								
-							for (int i = (int)(ll.size()) - 1; i > 0; i--)
-								for (int m = i-1; m >= 0; m--)
-									mma[ll[i]].insert(ll[m]);
+							mma[it->second].insert(p.first);
+							it = slppa.find(it->second);
 						}
 					}
 				}
+				else if (ok && haa && haa->size && haa->capacity)
+					this->sparseCountsDescendants(*haa, slppa, qqa, mma);
 				// get top nmax vars by entropy
 				// remove any sparse parents with same entropy as children
 				if (ok && (qqr.size() || qqa.size()))
 				{
-					auto nmax = (std::size_t)std::sqrt(pp.znnmax / (double)(2*sliceSizeA));
+					auto nmax = (std::size_t)std::sqrt(pp.znnmax / (double)(2*sampleSizeA));
 					nmax = std::max(nmax, pp.bmax);
 					DoubleSizePairList ee;
 					ee.reserve(qqr.size() + qqa.size());
-					if (qqr.size())
+					if (qqr.size() && countsIs)
+					{
+						double f = 1.0/(double)sampleSizeA;
+						for (auto v : qqr)
+						{
+							auto it = countsA.repa.find(v);
+							if (it == countsA.repa.end())
+								continue;
+							double e = sliceCountsEntropy(it->second, f);
+							if (e > repaRounding)
+								ee.push_back(DoubleSizePair(-e,v));
+						}
+					}
+					else if (qqr.size())
 					{
 						SizeList vv(qqr.begin(),qqr.end());
 						auto eer = prents(*hrpr(vv.size(), vv.data(), *hrr));
@@ -1265,7 +2871,7 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 					{
 						std::map<std::size_t, SizeSet> eem0;
 						for (auto p : qqa)	
-							if (p.second > 0 && p.second < sliceSizeA)		
+							if (p.second > 0 && p.second < sampleSizeA)		
 								eem0[p.second].insert(p.first);
 						std::map<std::size_t, SizeSet> eem;
 						for (auto p : eem0)		
@@ -1291,7 +2897,7 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 									eem[e].insert(v);
 							}
 						}	
-						double f = 1.0/(double)sliceSizeA;
+						double f = 1.0/(double)sampleSizeA;
 						for (auto& p : eem)	
 						{
 							double a = (double)p.first * f;
@@ -1322,7 +2928,7 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 					fail = ok && !qqr.size() && !qqa.size();
 					if (ok && this->logging)
 					{
-						std::lock_guard<std::mutex> guard(this->mutex);	
+						ActiveLockGuard guard(this->mutex, this->lockStats, "induce log", !this->logQueue, true);	
 						if (!fail)
 						{
 							LOG "induce model\tslice: " << std::hex << sliceA << std::dec << "\trepa dimension: " << qqr.size() << "\tsparse dimension: " << qqa.size() UNLOG
@@ -1333,6 +2939,11 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 						}
 					}	
 				}	
+				if (ok && !fail && cancelled())
+				{
+					fail = true;
+					cancelledA = true;
+				}
 				if (ok && !fail)
 				{
 					std::unique_ptr<HistoryRepa> hrs;
@@ -1361,7 +2972,7 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 							hras->vectorVar = new std::size_t[n];
 							hra->shape = new std::size_t[n];
 							hras->shape = new std::size_t[n];
-							auto za = sliceSizeA;
+							auto za = sampleSizeA;
 							hra->size = za;
 							hras->size = za;
 							hra->evient = false;
@@ -1450,7 +3061,7 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 						ok = ok && hr && hrs 
 							&& hr->dimension == (qqr.size() + qqa.size()) 
 							&& hr->dimension == hrs->dimension 
-							&& hr->size == sliceSizeA
+							&& hr->size == sampleSizeA
 							&& hr->size == hrs->size;
 						if (!ok)
 						{
@@ -1459,11 +3070,16 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 					}
 					if (ok && this->logging)
 					{
-						std::lock_guard<std::mutex> guard(this->mutex);	
+						ActiveLockGuard guard(this->mutex, this->lockStats, "induce log", !this->logQueue, true);	
 						LOG "induce model\tslice: " << std::hex << sliceA << std::dec << "\tdimension: " << hr->dimension << "\tsize: " << hr->size UNLOG
 					}						
+					if (ok && cancelled())
+					{
+						fail = true;
+						cancelledA = true;
+					}
 					// layerer
-					if (ok)
+					if (ok && !fail)
 					{
 						try
 						{
@@ -1475,7 +3091,10 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 								for (std::size_t i = 0; i < n; i++)
 									vv.push_back(vv1[i]);
 							}
-							auto t = layerer(pp.wmax, pp.lmax, pp.xmax, pp.omax, pp.bmax, pp.mmax, pp.umax, pp.pmax, pp.tint, vv, *hr, *hrs, layerer_log, this->logging && pp.logging, varA);
+							// the layerer itself is not cancelled in process, a forked child is killed instead
+							auto t = forkChild
+								? layerer(pp.wmax, pp.lmax, pp.xmax, pp.omax, pp.bmax, pp.mmax, pp.umax, pp.pmax, tint, vv, *hr, *hrs, layerer_log_none, false, varA)
+								: layerer(pp.wmax, pp.lmax, pp.xmax, pp.omax, pp.bmax, pp.mmax, pp.umax, pp.pmax, tint, vv, *hr, *hrs, layerer_log, this->logging && pp.logging, varA);
 							fr = std::move(std::get<0>(t));
 							auto mm = std::move(std::get<1>(t));
 							fail = !fr || (!mm || !mm->size());
@@ -1485,8 +3104,11 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 								SizeUSet kk1(kk.begin(), kk.end());
 								SizeUSet vv1(vv.begin(), vv.end());
 								fr = llfr(vv1, *frdep(*fr, kk1));
-								frSize = fudRepasSize(*fr);
 								algn = mm->back().first;
+							}
+							if (ok && !fail)
+							{
+								frSize = fudRepasSize(*fr);
 								auto m = kk.size();
 								auto z = hr->size;
 								diagonal = 100.0*(algn/z/(m-1)*exp(1.0));
@@ -1500,7 +3122,7 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 						}
 						if (ok && this->logging)
 						{
-							std::lock_guard<std::mutex> guard(this->mutex);	
+							ActiveLockGuard guard(this->mutex, this->lockStats, "induce log", !this->logQueue, true);	
 							if (!fail)
 							{
 								LOG "induce model\tslice: " << std::hex << sliceA << std::dec << "\tder vars algn density: " << algn << "\timpl bi-valency percent: " << diagonal << "\tder vars cardinality: " << kk.size() << "\tfud cardinality: " << frSize UNLOG							
@@ -1514,17 +3136,330 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 				}
 				if (ok && this->logging)
 				{
-					std::lock_guard<std::mutex> guard(this->mutex);	
+					ActiveLockGuard guard(this->mutex, this->lockStats, "induce log", !this->logQueue, true);	
 					LOG "induce model\tslice: " << std::hex << sliceA << std::dec << "\ttime: " << ((sec)(clk::now() - mark)).count() << "s" UNLOG
 				}				
 			}
+			if (ok && !fail && !forked && cancelled())
+			{
+				fail = true;
+				cancelledA = true;
+			}
+			// multiply the induced history by the fud once while unlocked, to get both the reduced histogram
+			// that defines the child slices and the state of each event, the reframing only renames the variables
+			std::unique_ptr<HistogramRepa> ar;
+			SizeList statesA;
+			if (ok && !fail && !forked)
+			{
+				auto m = kk.size();
+				auto hrm = frmul(tint, *hr, *fr);
+				ar = hrred(1.0, m, kk.data(), *hrm);
+				auto& mvv = hrm->mapVarInt();
+				SizeList skk(m);
+				SizeList ii(m);
+				for (std::size_t i = 0; ok && i < m; i++)
+				{
+					auto it = mvv.find(kk[i]);
+					ok = ok && it != mvv.end();
+					if (ok)
+					{
+						ii[i] = it->second;
+						skk[i] = hrm->shape[it->second];
+					}
+				}
+				if (!ok)
+				{
+					LOG "induce\tslice: " << std::hex << sliceA << std::dec << "\terror: derived variables not found" UNLOG
+				}
+				auto z = hrm->size;
+				auto n = hrm->dimension;
+				auto rr = hrm->arr;	
+				statesA.reserve(z);
+				for (std::size_t j = 0; ok && j < z; j++)
+				{
+					std::size_t k = 0;
+					for (std::size_t i = 0; i < m; i++)
+						k = skk[i]*k + (hrm->evient ? rr[j*n + ii[i]] : rr[ii[i]*z + j]);
+					statesA.push_back(k);
+				}
+			}
+#ifdef __linux__
+			// the child sends the copied events, the model and the states of the events to the parent and exits
+			if (forkChild)
+			{
+				std::ostringstream out;
+				auto outList = [&out](const SizeList& ll)
+				{
+					std::size_t hsize = ll.size();
+					out.write(reinterpret_cast<const char*>(&hsize), sizeof(std::size_t));
+					out.write(reinterpret_cast<const char*>(ll.data()), hsize*sizeof(std::size_t));
+				};
+				unsigned char found = ok && !fail;
+				out.write(reinterpret_cast<char*>(&found), 1);
+				if (found)
+				{
+					out.write(reinterpret_cast<char*>(&sliceSizeA), sizeof(std::size_t));
+					outList(eventsA);
+					outList(kk);
+					out.write(reinterpret_cast<char*>(&algn), sizeof(double));
+					out.write(reinterpret_cast<char*>(&diagonal), sizeof(double));
+					// the fud is sent as a decomp of one fud preceded by the sizes of its layers
+					SizeList lsizes;
+					DecompFudSlicedRepa dr;
+					dr.fuds.push_back(FudSlicedStruct());
+					auto& fs = dr.fuds.back();
+					fs.parent = sliceA;
+					for (auto& ll : fr->layers)
+					{
+						lsizes.push_back(ll.size());
+						fs.fud.insert(fs.fud.end(), ll.begin(), ll.end());
+					}
+					outList(lsizes);
+					decompFudSlicedRepasPersistent(dr, out);
+					SizeList skk(ar->shape, ar->shape + kk.size());
+					outList(skk);
+					std::size_t sz = 1;
+					for (auto s : skk)
+						sz *= s;
+					out.write(reinterpret_cast<char*>(ar->arr), sz*sizeof(double));
+					outList(statesA);
+				}
+				auto str = out.str();
+				std::size_t k = 0;
+				while (k < str.size())
+				{
+					auto n = write(forkPipe[1], str.data() + k, str.size() - k);
+					if (n <= 0)
+						break;
+					k += n;
+				}
+				_exit(ok && k == str.size() ? 0 : 1);
+			}
+			// the parent receives the child's result, a child that ends abnormally fails the induction
+			if (forked)
+			{
+				auto mark = (ok && this->logging) ? clk::now() : std::chrono::time_point<clk>();
+				forkRead(std::numeric_limits<std::size_t>::max());
+				int status = forkStop();
+				bool exited = !forkKilled && WIFEXITED(status) && !WEXITSTATUS(status) && forkStr.size() >= 2 && forkStr[0];
+				fail = !exited || !forkStr[1];
+				cancelledA = forkKilled;
+				if (!exited && !forkKilled)
+				{
+					LOG "induce\tslice: " << std::hex << sliceA << std::dec << "\terror: forked induction ended abnormally" << (WIFSIGNALED(status) ? "\tsignal: " : "\tstatus: ") << (WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status)) UNLOG
+				}
+				if (!fail)
+				{
+					std::istringstream in(forkStr.substr(2));
+					auto inList = [&in](SizeList& ll)
+					{
+						std::size_t hsize = 0;
+						in.read(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+						if (!in || hsize > ((std::size_t)1 << 40))
+						{
+							in.setstate(std::ios::failbit);
+							return;
+						}
+						ll.resize(hsize);
+						in.read(reinterpret_cast<char*>(ll.data()), hsize*sizeof(std::size_t));
+					};
+					in.read(reinterpret_cast<char*>(&sliceSizeA), sizeof(std::size_t));
+					inList(eventsA);
+					inList(kk);
+					in.read(reinterpret_cast<char*>(&algn), sizeof(double));
+					in.read(reinterpret_cast<char*>(&diagonal), sizeof(double));
+					SizeList lsizes;
+					inList(lsizes);
+					auto dr = in ? persistentsDecompFudSlicedRepa(in) : std::unique_ptr<DecompFudSlicedRepa>();
+					fail = !in || !dr || dr->fuds.size() != 1 || !kk.size();
+					if (!fail)
+					{
+						auto& fud = dr->fuds.front().fud;
+						fr = std::make_unique<FudRepa>();
+						fr->layers.reserve(lsizes.size());
+						std::size_t k = 0;
+						for (auto lsize : lsizes)
+						{
+							fail = fail || k + lsize > fud.size();
+							if (fail)
+								break;
+							fr->layers.push_back(TransformRepaPtrList(fud.begin() + k, fud.begin() + k + lsize));
+							k += lsize;
+						}
+						fail = fail || k != fud.size();
+					}
+					SizeList skk;
+					if (!fail)
+						inList(skk);
+					std::size_t sz = 1;
+					for (auto s : skk)
+						sz *= s;
+					fail = fail || !in || skk.size() != kk.size() || sz > ((std::size_t)1 << this->bits);
+					if (!fail)
+					{
+						auto m = kk.size();
+						ar = std::make_unique<HistogramRepa>();
+						ar->dimension = m;
+						ar->vectorVar = new std::size_t[m];
+						ar->shape = new std::size_t[m];
+						for (std::size_t i = 0; i < m; i++)
+						{
+							ar->vectorVar[i] = kk[i];
+							ar->shape[i] = skk[i];
+						}
+						ar->arr = new double[sz];
+						in.read(reinterpret_cast<char*>(ar->arr), sz*sizeof(double));
+						inList(statesA);
+					}
+					fail = fail || !in || statesA.size() != eventsA.size();
+					if (fail)
+					{
+						LOG "induce\tslice: " << std::hex << sliceA << std::dec << "\terror: inconsistent forked model" UNLOG
+					}
+					else
+						frSize = fudRepasSize(*fr);
+				}
+				if (ok && this->logging)
+				{
+					ActiveLockGuard guard(this->mutex, this->lockStats, "induce log", !this->logQueue, true);	
+					if (!fail)
+					{
+						LOG "induce model\tslice: " << std::hex << sliceA << std::dec << "\tforked\tder vars algn density: " << algn << "\timpl bi-valency percent: " << diagonal << "\tder vars cardinality: " << kk.size() << "\tfud cardinality: " << frSize << "\ttime: " << ((sec)(clk::now() - mark)).count() << "s" UNLOG
+					}
+					else
+					{
+						LOG "induce model\tslice: " << std::hex << sliceA << std::dec << "\tforked\tno model\ttime: " << ((sec)(clk::now() - mark)).count() << "s" UNLOG
+					}
+				}
+			}
+#endif
+			// the copied events are moved to the children by their states, and then the rest of the events of the slice
+			// are tidied by walking the new fud, the sample and counts of each event are moved with it
+			// with commitTimeMax both are done in steps of bounded time, releasing the lock in between
+			std::size_t v = 0;
+			SizeList sl;
+			SizeSizeUMap indexChild;
+			std::size_t remainderChild = 0;
+			std::size_t assignedA = 0;
+			bool tidied = true;
+			auto markCommit = clk::now();
+			auto overrun = [&](std::chrono::time_point<clk> markStep)
+			{
+				return pp.commitTimeMax > 0.0 && ((sec)(clk::now() - markStep)).count() > pp.commitTimeMax;
+			};
+			auto move = [&](SizeSet& eventsB, std::size_t eventB, std::size_t sliceB)
+			{
+				this->historySparse->arr[eventB] = sliceB;
+				auto node = eventsB.extract(eventB);
+				auto& setB = this->historySlicesSetEvent[sliceB];
+				if (node)
+					setB.insert(std::move(node));
+				else
+					setB.insert(eventB);
+				if (this->induceSampleSize)
+				{
+					this->sampleRemove(sliceA, eventB);
+					this->sampleInsert(sliceB, eventB);
+				}
+				if (this->induceCountsIs)
+				{
+					this->sliceCountsEvent(sliceA, eventB, false);
+					this->sliceCountsEvent(sliceB, eventB, true);
+				}
+			};
+			auto assign = [&](std::chrono::time_point<clk> markStep)
+			{
+				auto slicesIt = this->historySlicesSetEvent.find(sliceA);
+				// if the ring has been remapped the rest of the copied events are left to the tidy
+				if (this->historyGeneration != historyGenerationA || slicesIt == this->historySlicesSetEvent.end())
+				{
+					assignedA = statesA.size();
+					return;
+				}
+				auto& eventsB = slicesIt->second;
+				auto rs = this->historySparse->arr;
+				SizeSet slices;
+				std::size_t steps = 0;
+				while (assignedA < statesA.size())
+				{
+					if (steps && overrun(markStep))
+						break;
+					steps++;
+					auto j = assignedA;
+					assignedA++;
+					auto it = indexChild.find(statesA[j]);
+					auto sliceB = it != indexChild.end() ? it->second : remainderChild;
+					auto eventB = eventsA[j];
+					// events moved to another slice since the copy, for example by reslice, are left where they are
+					if (!sliceB || rs[eventB] != sliceA)
+						continue;
+					move(eventsB, eventB, sliceB);
+					slices.insert(sliceB);
+				}
+				for (auto sliceB : slices)
+					if (this->induceThreshold && this->historySlicesSetEvent[sliceB].size() >= induceThreshold)
+						this->induceSlices.insert(sliceB);
+			};
+			auto tidy = [&](std::chrono::time_point<clk> markStep)
+			{
+				auto slicesIt = this->historySlicesSetEvent.find(sliceA);
+				if (slicesIt == this->historySlicesSetEvent.end())
+					return true;
+				auto& eventsB = slicesIt->second;
+				SizeSet slices;
+				SizeUCharStructList jj;
+				ActiveVarValueMap mm;
+				auto ll = std::make_unique<SizeList>();
+				std::size_t steps = 0;
+				while (ok && eventsB.size())
+				{
+					if (steps && overrun(markStep))
+						break;
+					steps++;
+					auto eventB = *eventsB.begin();
+					jj.clear();
+					this->eventListVarValues(eventB, true, jj);
+					this->eventPathSlice(jj, ppu.mapCapacity, mm, *ll);
+					ok = ok && ll->size() && ll->back() && ll->back() != sliceA;
+					if (!ok)
+					{
+						LOG "induce update\tslice: " << std::hex << sliceA << std::dec << "\terror: drmul failed to return a list" UNLOG
+						break;
+					}						
+					std::size_t	sliceB = ll->back();
+					move(eventsB, eventB, sliceB);
+					slices.insert(sliceB);									
+				}
+				if (ok)
+				{
+					for (auto sliceB : slices)
+						if (this->induceThreshold && this->historySlicesSetEvent[sliceB].size() >= induceThreshold)
+							this->induceSlices.insert(sliceB);
+				}
+				if (ok && eventsB.size())
+					return false;
+				this->historySlicesSetEvent.erase(sliceA);
+				return true;
+			};
+			// a step of the commit assigns and then tidies until the step overruns
+			auto step = [&](std::chrono::time_point<clk> markStep)
+			{
+				if (assignedA < statesA.size())
+					assign(markStep);
+				return assignedA == statesA.size() && !overrun(markStep) && tidy(markStep);
+			};
 			// add new fud to locked active and update
 			if (ok && !fail)	
 			{
-				auto mark = (ok && this->logging) ? clk::now() : std::chrono::time_point<clk>();
-				std::lock_guard<std::mutex> guard(this->mutex);		
+				ActiveLockGuard guard(this->mutex, this->lockStats, "induce commit");		
+				// check that the ring has not been remapped since the copy, otherwise the copied events are stale
+				if (ok && this->historyGeneration != historyGenerationA)
+				{
+					fail = true;
+					LOG "induce\tslice: " << std::hex << sliceA << std::dec << "\twarning: history remapped during induction" UNLOG
+				}
 				// check active system
-				if (ok)
+				if (ok && !fail)
 				{
 					ok = ok && this->system;
 					if (!ok)
@@ -1533,7 +3468,7 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 					}	
 				}
 				// remap kk and fr with block ids
-				if (ok)
+				if (ok && !fail)
 				{
 					if (frSize > ((std::size_t)1 << this->bits))
 					{
@@ -1554,24 +3489,18 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 					for (std::size_t i = 0; i < kk.size(); i++)	
 						kk[i] = nn[kk[i]];	
 				}				
-				std::size_t v = 0;
-				SizeList sl;
 				// create the slices
-				if (ok)
+				if (ok && !fail)
 				{		
 					if (!this->decomp)
 						this->decomp = std::make_unique<DecompFudSlicedRepa>();
 					auto m = kk.size();
-					auto ar = hrred(1.0, m, kk.data(), *frmul(pp.tint, *hr, *fr));
 					std::size_t sz = 1;
 					auto skk = ar->shape;
 					auto rr0 = ar->arr;
 					for (std::size_t i = 0; i < m; i++)
 						sz *= skk[i];
 					sl.reserve(sz);
-					fr->layers.push_back(TransformRepaPtrList());
-					auto& ll = fr->layers.back();
-					ll.reserve(sz);					
 					if (sz > ((std::size_t)1 << this->bits))
 					{
 						ok = false;
@@ -1579,119 +3508,62 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 					}
 					if (((this->varSlice + sz) >> this->bits) > (this->varSlice >> this->bits))
 						this->varSlice = this->system->next(this->bits);					
-					bool remainder = false;
-					for (std::size_t i = 0; i < sz; i++)
+					if (this->sliceIndicatorIs)
 					{
-						if (rr0[i] <= 0.0)
-						{
-							remainder = true;
-							continue;
-						}
-						auto tr = std::make_shared<TransformRepa>();
-						if (sliceA)
-						{
-							tr->dimension = m + 1;
-							tr->vectorVar = new std::size_t[m + 1];
-							auto ww = tr->vectorVar;
-							tr->shape = new std::size_t[m + 1];
-							auto sh = tr->shape;
-							ww[0] = sliceA;
-							sh[0] = 2;
-							for (std::size_t j = 0; j < m; j++)
+						auto& si = this->sliceIndicators[sliceA];
+						si = ActiveSliceIndicator();
+						si.vars = kk;
+						si.shape.assign(skk, skk + m);
+						bool remainder = false;
+						for (std::size_t i = 0; i < sz; i++)
+							if (rr0[i] > 0.0)
 							{
-								ww[j + 1] = kk[j];
-								sh[j + 1] = skk[j];
+								si.indexChild[i] = this->varSlice;
+								sl.push_back(this->varSlice);
+								this->varSlice++;
 							}
-							tr->arr = new unsigned char[2 * sz];
-							auto rr = tr->arr;
-							for (std::size_t j = 0; j < 2 * sz; j++)
-								rr[j] = 0;
-							rr[sz + i] = 1;
-						}
-						else
+							else
+								remainder = true;
+						if (remainder)
 						{
-							tr->dimension = m;
-							tr->vectorVar = new std::size_t[m];
-							auto ww = tr->vectorVar;
-							tr->shape = new std::size_t[m];
-							auto sh = tr->shape;
-							for (std::size_t j = 0; j < m; j++)
-							{
-								ww[j] = kk[j];
-								sh[j] = skk[j];
-							}
-							tr->arr = new unsigned char[sz];
-							auto rr = tr->arr;
-							for (std::size_t j = 0; j < sz; j++)
-								rr[j] = 0;
-							rr[i] = 1;
+							si.remainder = this->varSlice;
+							sl.push_back(this->varSlice);
+							this->varSlice++;
 						}
-						tr->valency = 2;						
-						auto w = this->varSlice;
-						this->varSlice++;
-						tr->derived = w;
-						sl.push_back(w);
-						ll.push_back(tr);
+						indexChild = si.indexChild;
+						remainderChild = si.remainder;
 					}
-					if (remainder)
+					else
 					{
-						auto tr = std::make_shared<TransformRepa>();
-						if (sliceA)
-						{
-							tr->dimension = m + 1;
-							tr->vectorVar = new std::size_t[m + 1];
-							auto ww = tr->vectorVar;
-							tr->shape = new std::size_t[m + 1];
-							auto sh = tr->shape;
-							ww[0] = sliceA;
-							sh[0] = 2;
-							for (std::size_t j = 0; j < m; j++)
-							{
-								ww[j + 1] = kk[j];
-								sh[j + 1] = skk[j];
-							}
-							tr->arr = new unsigned char[2 * sz];
-							auto rr = tr->arr;
-							for (std::size_t j = 0; j < 2 * sz; j++)
-								rr[j] = j >= sz && rr0[j - sz] <= 0.0 ? 1 : 0;
-						}
-						else
-						{
-							tr->dimension = m;
-							tr->vectorVar = new std::size_t[m];
-							auto ww = tr->vectorVar;
-							tr->shape = new std::size_t[m];
-							auto sh = tr->shape;
-							for (std::size_t j = 0; j < m; j++)
+						fr->layers.push_back(TransformRepaPtrList());
+						auto& ll = fr->layers.back();
+						ll.reserve(sz);					
+						this->sliceTransforms(sliceA, kk, skk, rr0, sz, ll, sl);
+						// the slice transforms are in the order of the states with non-zero counts followed by the remainder
+						std::size_t k = 0;
+						for (std::size_t i = 0; i < sz && k < sl.size(); i++)
+							if (rr0[i] > 0.0)
 							{
-								ww[j] = kk[j];
-								sh[j] = skk[j];
+								indexChild[i] = sl[k];
+								k++;
 							}
-							tr->arr = new unsigned char[sz];
-							auto rr = tr->arr;
-							for (std::size_t j = 0; j < sz; j++)
-								rr[j] = rr0[j] <= 0.0 ? 1 : 0;
-						}
-						tr->valency = 2;
-						auto w = this->varSlice;
-						this->varSlice++;
-						tr->derived = w;
-						sl.push_back(w);
-						ll.push_back(tr);
+						if (k < sl.size())
+							remainderChild = sl.back();
 					}
 				}
 				// update this decomp mapVarParent and mapVarInt
-				if (ok)
+				if (ok && !fail)
 				{
 					auto& dr = *this->decomp;
 					dr.fuds.push_back(FudSlicedStruct());
+					this->decompGeneration++;
 					auto& fs = dr.fuds.back();
 					fs.parent = sliceA;
 					fs.children = sl;
 					fs.fud.reserve(frSize + sl.size());
 					for (auto& ii : fr->layers)
 						for (auto& tr : ii)
-							fs.fud.push_back(tr);
+							fs.fud.push_back(this->arena ? activeArenaTransformRepa(this->arena, *tr) : tr);
 					dr.fudRepasSize += fs.fud.size();
 					auto& vi = dr.mapVarInt();
 					vi[sliceA] = dr.fuds.size() - 1;
@@ -1700,7 +3572,7 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 						cv[s] = sliceA;
 				}
 				// check historySparse
-				if (ok)
+				if (ok && !fail)
 				{
 					ok = ok && this->historySparse && this->historySparse->arr;
 					if (!ok)
@@ -1708,264 +3580,36 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 						LOG "induce update\tslice: " << std::hex << sliceA << std::dec << "\terror: historySparse not initialised" UNLOG
 					}
 				}
-				// update historySparse and historySlicesSetEvent
-				if (ok)
+				// update historySparse and historySlicesSetEvent and tidy new events
+				if (ok && !fail)
 				{
-					if (sliceA)
-					{
-						auto z = hr->size;
-						auto hrr = std::make_unique<HistoryRepa>();
-						hrr->dimension = 1;
-						hrr->vectorVar = new std::size_t[1];
-						hrr->vectorVar[0] = sliceA;
-						hrr->shape = new std::size_t[1];
-						hrr->shape[0] = 2;
-						hrr->size = z;
-						hrr->evient = hr->evient;
-						hrr->arr = new unsigned char[z];
-						auto rrr = hrr->arr;		
-						for (std::size_t j = 0; j < z; j++)
-							rrr[j] = 1;
-						hr = hrjoin(HistoryRepaPtrList{std::move(hr),std::move(hrr)});
-					}
-					hr = hrhrred(sl.size(), sl.data(), *frmul(pp.tint, *hr, *fr));
-					auto n = hr->dimension;
-					auto vv = hr->vectorVar;
-					auto z = hr->size;
-					auto rr = hr->arr;	
-					auto ev = eventsA.data();
-					SizeSet slices;
-					for (std::size_t j = 0; j < z; j++)
-						for (std::size_t i = 0; i < n; i++)
-						{
-							auto u = rr[i*z + j];
-							if (u)
-							{
-								auto sliceB = vv[i];
-								auto eventA = ev[j];
-								this->historySparse->arr[eventA] = sliceB;
-								this->historySlicesSetEvent[sliceA].erase(eventA);
-								this->historySlicesSetEvent[sliceB].insert(eventA);
-								slices.insert(sliceB);
-								break;
-							}
-						}
-					for (auto sliceB : slices)
-						if (this->historySlicesSetEvent[sliceB].size() >= induceThreshold)
-							this->induceSlices.insert(sliceB);
 					this->induceSlices.erase(sliceA);
 					this->induceSliceFailsSize.erase(sliceA);
+					tidied = step(clk::now());
+					// the children are not induced until the commit is finished
+					if (!tidied)
+						this->inducingSlices.insert(sl.begin(), sl.end());
 				}
-				// tidy new events
-				if (ok)
-				{
-					auto eventsB = this->historySlicesSetEvent[sliceA];
-					if (eventsB.size())
-					{
-						SizeSet slices;
-						for (auto eventB : eventsB)
-						{
-							SizeUCharStructList jj;
-							if (ok)
-							{
-								auto& comp = this->induceVarComputeds;
-								auto& slpp = this->underlyingSlicesParent;
-								auto promote = this->underlyingOffsetIs;
-								auto& proms = this->underlyingsVarsOffset;		
-								std::size_t block1 = (std::size_t)1 << this->bits;
-								SizeList frameUnderlyingsA(this->frameUnderlyings);
-								if (!frameUnderlyingsA.size())
-									frameUnderlyingsA.push_back(0);	
-								std::size_t m = 0;
-								for (auto& hr : this->underlyingHistoryRepa)
-									m += hr->dimension*frameUnderlyingsA.size();
-								m += 50*this->underlyingHistorySparse.size()*frameUnderlyingsA.size();
-								m += 50*this->frameHistorys.size();
-								jj.reserve(m);
-								auto z = this->historySize;
-								auto over = this->historyOverflow;
-								auto j = eventB;
-								for (std::size_t g = 0; g < frameUnderlyingsA.size(); g++)
-								{
-									auto f = frameUnderlyingsA[g];
-									if (this->frameUnderlyingDynamicIs)
-									{
-										auto& frameUnderlyingsB = this->historyFrameUnderlying[j];
-										if (g < frameUnderlyingsB.size())
-											f = frameUnderlyingsB[g];
-										else
-											f = 0;
-									}
-									if (g && !f)
-										continue;
-									auto& mm = this->framesVarsOffset[g];
-									for (auto& hr : this->underlyingHistoryRepa)
-									{
-										auto n = hr->dimension;
-										auto vv = hr->vectorVar;
-										auto sh = hr->shape;
-										auto rr = hr->arr;	
-										for (std::size_t i = 0; i < n; i++)
-										{
-											SizeUCharStruct qq;
-											qq.size = vv[i];
-											if (f <= j)
-												qq.uchar = rr[(j-f)*n + i];	
-											else if (f && over && z > f)
-												qq.uchar = rr[((j+z-f)%z)*n + i];	
-											else
-												qq.uchar = 0;
-											if (comp.count(qq.size)) // computed
-											{
-												std::size_t s = sh[i];
-												std::size_t b = 0; 
-												if (s)
-												{
-													s--;
-													while (s >> b)
-														b++;
-												}
-												qq.size = block1 + (qq.size << 12) + (b << 8) + qq.uchar;
-												qq.uchar = 1;
-												auto it = slpp.find(qq.size);
-												if (f)
-													this->varPromote(mm, qq.size);
-												jj.push_back(qq);
-												while (it != slpp.end() && it->second)
-												{
-													qq.size = it->second;
-													if (f)
-														this->varPromote(mm, qq.size);
-													jj.push_back(qq);
-													it = slpp.find(it->second);
-												}
-											}
-											else if (qq.uchar)
-											{
-												if (f)
-													this->varPromote(mm, qq.size);
-												jj.push_back(qq);
-											}
-										}							
-									}
-									auto& slpp = this->underlyingSlicesParent;
-									std::size_t h = 0;									
-									for (auto& hr : this->underlyingHistorySparse)
-									{
-										std::size_t v = 0;
-										if (f <= j)
-											v = hr->arr[j-f];
-										else if (f && over && z > f)
-											v = hr->arr[(j+z-f)%z]; 
-										if (v)
-										{
-											{
-												SizeUCharStruct qq;
-												qq.uchar = 1;			
-												qq.size = v;
-												if (promote)
-													this->varPromote(proms[h], qq.size);
-												if (f)
-													this->varPromote(mm, qq.size);
-												jj.push_back(qq);
-											}								
-											auto it = slpp.find(v);
-											while (it != slpp.end())
-											{
-												SizeUCharStruct qq;
-												qq.uchar = 1;
-												qq.size = it->second;
-												if (!qq.size)
-													break;
-												if (promote)
-													this->varPromote(proms[h], qq.size);
-												if (f)
-													this->varPromote(mm, qq.size);
-												jj.push_back(qq);
-												it = slpp.find(it->second);
-											}										
-										}
-										h++;
-									}										
-								}
-								if (ok && this->decomp && this->historySparse && this->frameHistorys.size())
-								{
-									auto& hr = this->historySparse;
-									auto& slpp = this->decomp->mapVarParent();
-									for (std::size_t g = 0; g < this->frameHistorys.size(); g++)
-									{
-										std::size_t f = this->frameHistorys[g];
-										if (this->frameHistoryDynamicIs)
-										{
-											auto& frameHistorysB = this->historyFrameHistory[j];
-											if (g < frameHistorysB.size())
-												f = frameHistorysB[g];
-											else
-												f = 0;
-										}
-										if (!f)
-											continue;
-										auto& mm = this->framesVarsOffset[g];
-										std::size_t v = 0;
-										if (f <= j)
-											v = hr->arr[j-f];
-										else if (f && over && z > f)
-											v = hr->arr[(j+z-f)%z]; 
-										if (v)
-										{
-											{
-												SizeUCharStruct qq;
-												qq.uchar = 1;			
-												qq.size = v;
-												if (f)
-													this->varPromote(mm, qq.size);
-												jj.push_back(qq);
-											}								
-											auto it = slpp.find(v);
-											while (it != slpp.end())
-											{
-												SizeUCharStruct qq;
-												qq.uchar = 1;
-												qq.size = it->second;
-												if (!qq.size)
-													break;
-												if (f)
-													this->varPromote(mm, qq.size);
-												jj.push_back(qq);
-												it = slpp.find(it->second);
-											}										
-										}
-									}
-								}
-							}
-							std::unique_ptr<SizeList> ll;
-							if (ok)
-							{
-								ll = drmul(jj,*this->decomp,(unsigned char)(ppu.mapCapacity));	
-								ok = ok && ll && ll->size() && ll->back();
-								if (!ok)
-								{
-									LOG "induce update\tslice: " << std::hex << sliceA << std::dec << "\terror: drmul failed to return a list" UNLOG
-									break;
-								}						
-							}							
-							if (ok)
-							{
-								std::size_t	sliceB = ll->back();
-								this->historySparse->arr[eventB] = sliceB;
-								this->historySlicesSetEvent[sliceB].insert(eventB);	
-								slices.insert(sliceB);									
-							}
-						}
-						if (ok)
-						{
-							for (auto sliceB : slices)
-								if (this->induceThreshold && this->historySlicesSetEvent[sliceB].size() >= induceThreshold)
-									this->induceSlices.insert(sliceB);
-						}
-					}
-					this->historySlicesSetEvent.erase(sliceA);
-				}
+			}
+			// assign and tidy the rest of the events in steps, each under a brief lock
+			while (ok && !fail && !tidied)
+			{
+				std::this_thread::yield();
+				ActiveLockGuard guard(this->mutex, this->lockStats, "induce commit tidy");		
+				tidied = step(clk::now());
+			}
+			// finish the commit
+			if (ok && !fail)	
+			{
+				auto mark = markCommit;
+				ActiveLockGuard guard(this->mutex, this->lockStats, "induce commit finish");		
+				for (auto sliceB : sl)
+					this->inducingSlices.erase(sliceB);
+				// the sample and counts of the slice are empty once all of its events have moved
+				if (ok && this->induceSampleSize)
+					this->sampleSlice(sliceA);
+				if (ok && this->induceCountsIs)
+					this->historySlicesCounts.erase(sliceA);
 				// handle cached sizes and transitions
 				if (ok && this->historySliceCachingIs)
 				{
@@ -1992,23 +3636,41 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 								events.insert(slicesIt->second.begin(),slicesIt->second.end());
 						}
 					}
+					SizeSet slicesIndexed;
 					if (cont)
 					{
-						for (auto sliceC : prevs[sliceA])
+						// remove the transitions of the slice and of any children updated while the tidy was in steps
+						SizeList slicesRemoved {sliceA};
+						slicesRemoved.insert(slicesRemoved.end(), sl.begin(), sl.end());
+						for (auto sliceB : slicesRemoved)
 						{
-							nexts[sliceC].erase(sliceA);
-							if (!nexts[sliceC].size())
-								nexts.erase(sliceC);
-						}
-						for (auto pp : nexts[sliceA])
-						{
-							auto sliceC = pp.first;
-							prevs[sliceC].erase(sliceA);
-							if (!prevs[sliceC].size())
-								prevs.erase(sliceC);
+							auto prevsIt = prevs.find(sliceB);
+							if (prevsIt != prevs.end())
+								for (auto sliceC : prevsIt->second)
+								{
+									slicesIndexed.insert(sliceC);
+									auto nextsIt = nexts.find(sliceC);
+									if (nextsIt == nexts.end())
+										continue;
+									nextsIt->second.erase(sliceB);
+									if (!nextsIt->second.size())
+										nexts.erase(nextsIt);
+								}
+							auto nextsIt = nexts.find(sliceB);
+							if (nextsIt != nexts.end())
+								for (auto pp : nextsIt->second)
+								{
+									auto sliceC = pp.first;
+									auto prevsIt1 = prevs.find(sliceC);
+									if (prevsIt1 == prevs.end())
+										continue;
+									prevsIt1->second.erase(sliceB);
+									if (!prevsIt1->second.size())
+										prevs.erase(prevsIt1);
+								}
+							prevs.erase(sliceB);
+							nexts.erase(sliceB);
 						}
-						prevs.erase(sliceA);
-						nexts.erase(sliceA);
 						for (auto ev : events)
 						{
 							auto sliceB = rs[ev];	
@@ -2033,6 +3695,23 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 							}								
 						}						
 					}
+					// reindex the successors of the slice, its children and their predecessors
+					if (cont && this->transitionIndexIs)
+					{
+						slicesIndexed.insert(sliceA);
+						for (auto sliceB : sl)
+						{
+							slicesIndexed.insert(sliceB);
+							auto it = prevs.find(sliceB);
+							if (it != prevs.end())
+								slicesIndexed.insert(it->second.begin(), it->second.end());
+						}
+						for (auto sliceC : slicesIndexed)
+						{
+							auto it = nexts.find(sliceC);
+							this->transitionIndex.assign(sliceC, it != nexts.end() ? it->second : SizeSizeMap());
+						}
+					}
 				}				
 				// remove from inducingSlices if running async
 				if (ok && pp.asyncThreadMax)
@@ -2054,6 +3733,11 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 						LOG "induce summary\tslice: " << std::hex << sliceA << std::dec << "\tdiagonal: " << diagonal << "\tfud cardinality: " << this->decomp->fuds.size() << "\tmodel cardinality: " << this->decomp->fudRepasSize<< "\tfuds per threshold: " << (double)this->decomp->fuds.size() * this->induceThreshold / sizeA << "\tat: " << ts.c_str() UNLOG
 					}
 				}	
+				this->induceDuration = ((sec)(clk::now() - markInduce)).count();
+				if (ok && this->recorder)
+				{
+					this->recordInduce(sliceA, sliceSizeA, false, this->induceDuration, pp);
+				}	
 				if (ok && induceCallback)
 				{
 					ok = ok && induceCallback(*this,sliceA,sliceSizeA);
@@ -2062,7 +3746,7 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 			if (ok && fail)
 			{
 				auto mark = (ok && this->logging) ? clk::now() : std::chrono::time_point<clk>();
-				std::lock_guard<std::mutex> guard(this->mutex);		
+				ActiveLockGuard guard(this->mutex, this->lockStats, "induce fail");		
 				this->induceSliceFailsSize.insert_or_assign(sliceA, sliceSizeA);
 				// remove from inducingSlices if running async
 				if (ok && pp.asyncThreadMax)
@@ -2071,8 +3755,12 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 				}
 				if (ok && this->logging)
 				{
-					LOG "induce update fail\tslice: " << std::hex << sliceA << std::dec << "\tslice size: " << sliceSizeA << "\tfails: " << this->induceSliceFailsSize  << "\ttime: " << ((sec)(clk::now() - mark)).count() << "s" UNLOG
+					LOG "induce update fail\tslice: " << std::hex << sliceA << std::dec << "\tslice size: " << sliceSizeA << (cancelledA ? "\tcancelled" : "") << "\tfails: " << this->induceSliceFailsSize  << "\ttime: " << ((sec)(clk::now() - mark)).count() << "s" UNLOG
 				}					
+				if (ok && this->recorder)
+				{
+					this->recordInduce(sliceA, sliceSizeA, true, ((sec)(clk::now() - markInduce)).count(), pp);
+				}	
 			}
 		}
 	} 
@@ -2081,104 +3769,636 @@ bool Alignment::Active::induce(std::size_t sliceA, ActiveInduceParameters pp, Ac
 		LOG "induce error\tslice: " << std::hex << sliceA << std::dec << " : " << e.what()  UNLOG
 		ok = false;
 	}
+#ifdef __linux__
+	// a child that failed before sending its result exits here, and a parent that failed while forked reaps its child
+	if (forkChild)
+		_exit(1);
+	if (forkPid > 0)
+	{
+		kill(forkPid, SIGKILL);
+		close(forkPipe[0]);
+		waitpid(forkPid, 0, 0);
+	}
+#endif
 	if (!ok)
 		this->terminate = true;
 	
 	return ok;
 }
 
-bool Alignment::Active::dump(const ActiveIOParameters& pp)
+// recompute the cached sizes and transitions of the slices from the history
+void Alignment::Active::historySlicesCache()
+{
+	auto over = this->historyOverflow;
+	auto cont = this->continousIs;
+	auto& discont = this->continousHistoryEventsEvent;
+	auto z = this->historySize;
+	auto y = this->historyEvent;
+	auto rs = this->historySparse->arr;
+	auto& slices = this->historySlicesSetEvent;
+	auto& sizes = this->historySlicesSize;
+	auto& nexts = this->historySlicesSlicesSizeNext;
+	auto& prevs = this->historySlicesSliceSetPrev;
+	auto& cv = this->decomp->mapVarParent();
+	sizes.clear();
+	nexts.clear();
+	prevs.clear();
+	sizes.reserve(slices.size()*3);
+	nexts.reserve(slices.size());
+	prevs.reserve(slices.size());
+	for (auto pp : slices)
+	{
+		auto sliceC = pp.first;
+		auto a = pp.second.size();
+		while (true)
+		{
+			sizes[sliceC] += a;
+			if (!sliceC)
+				break;
+			sliceC = cv[sliceC];
+		}								
+	}	
+	if (cont)
+	{
+		auto j = over ? y : z;	
+		auto sliceB = rs[j%z];
+		j++;
+		while (j < y+z)
+		{
+			auto sliceC = rs[j%z];
+			if (sliceC != sliceB)
+			{
+				if (!discont.count(j%z))
+				{
+					nexts[sliceB][sliceC]++;
+					prevs[sliceC].insert(sliceB);
+				}
+				sliceB = sliceC;
+			}
+			j++;
+		}					
+	}
+}
+
+// rebuild the slices of the events, the slices to induce and the caches from historySparse
+void Alignment::Active::historySlicesRebuild()
+{
+	auto z = this->historySize;
+	auto count = this->historyOverflow ? z : this->historyEvent;
+	auto rs = this->historySparse->arr;
+	auto& slices = this->historySlicesSetEvent;
+	slices.clear();
+	for (std::size_t j = 0; j < count; j++)
+		slices[rs[j]].insert(j);
+	this->induceSlices.clear();
+	if (this->induceThreshold)
+		for (auto& pp : slices)
+			if (pp.second.size() >= this->induceThreshold)
+				this->induceSlices.insert(pp.first);
+	for (auto it = this->induceSliceFailsSize.begin(); it != this->induceSliceFailsSize.end();)
+	{
+		if (this->induceSlices.count(it->first))
+			it++;
+		else
+			it = this->induceSliceFailsSize.erase(it);
+	}
+	if (this->historySliceCachingIs && !this->historySliceCumulativeIs && this->decomp)
+		this->historySlicesCache();
+	if (this->transitionIndexIs)
+		this->transitionIndex.build(this->historySlicesSlicesSizeNext);
+	this->samplesRebuild();
+	this->slicesCountsRebuild();
+}
+
+// the most recent events are moved in order to the start of the new ring
+bool Alignment::Active::resize(std::size_t historySizeA)
 {
 	bool ok = true;
-	
-	std::ofstream out;
 	try 
 	{
-		auto mark = (ok && this->logging) ? clk::now() : std::chrono::time_point<clk>();
-		out.exceptions(out.failbit | out.badbit);
-		std::lock_guard<std::mutex> guard(this->mutex);
-		out.open(pp.filename, std::ios::binary);
-		if (ok)
-		{		
-			std::size_t h = this->name.size();
-			out.write(reinterpret_cast<char*>(&h), sizeof(std::size_t));
-			out.write(reinterpret_cast<char*>((char*)this->name.data()), h);
+		auto mark = clk::now();
+		ActiveLockGuard guard(this->mutex, this->lockStats, "resize");
+		ok = ok && historySizeA;
+		ok = ok && this->historySparse;
+		if (!ok)
+		{
+			LOG "resize\terror: no history or zero size" UNLOG
 		}
-		if (ok)
+		for (auto& hr : this->underlyingHistoryRepa)
 		{
-			std::size_t h = 1;
-			out.write(reinterpret_cast<char*>(&h), sizeof(std::size_t));
-			out.write(reinterpret_cast<char*>(&this->underlyingEventUpdated), sizeof(std::size_t));
+			ok = ok && hr && hr->evient;
+			if (!ok)
+			{
+				LOG "resize\terror: underlying history is not evient" UNLOG
+				break;
+			}
 		}
-		if (ok)
-		{		
-			out.write(reinterpret_cast<char*>(&this->historySize), sizeof(std::size_t));
-			out.write(reinterpret_cast<char*>(&this->historyOverflow), 1);
-			out.write(reinterpret_cast<char*>(&this->historyEvent), sizeof(std::size_t));
+		if (ok && historySizeA != this->historySize)
+		{
+			auto over = this->historyOverflow;
+			auto z = this->historySize;
+			auto y = this->historyEvent;
+			auto z1 = historySizeA;
+			// the old ring index of the new ring index j is (start + j) % z
+			std::size_t count = over ? z : y;
+			std::size_t count1 = std::min(count, z1);
+			std::size_t start = ((over ? y : 0) + count - count1) % z;
+			for (auto& hr : this->underlyingHistoryRepa)
+			{
+				auto n = hr->dimension;
+				auto rr = hr->arr;
+				auto rr1 = new unsigned char[z1*n];
+				std::memset(rr1, 0, z1*n);
+				for (std::size_t j = 0; j < count1; j++)
+					std::memcpy(rr1 + j*n, rr + ((start+j)%z)*n, n);
+				delete[] hr->arr;
+				hr->arr = rr1;
+				hr->size = z1;
+			}
+			auto sparse = [&](HistorySparseArray& hr)
+			{
+				auto hr1 = std::make_unique<HistorySparseArray>(z1,1);
+				auto rr = hr.arr;
+				auto rr1 = hr1->arr;
+				std::memset(rr1, 0, z1*sizeof(std::size_t));
+				for (std::size_t j = 0; j < count1; j++)
+					rr1[j] = rr[(start+j)%z];
+				return hr1;
+			};
+			for (auto& hr : this->underlyingHistorySparse)
+			{
+				auto hr1 = sparse(*hr);
+				hr = std::move(hr1);
+			}
+			this->historySparse = sparse(*this->historySparse);
+			// discontinuities of the kept events
+			{
+				SizeSizeMap discont;
+				for (auto& pp : this->continousHistoryEventsEvent)
+				{
+					auto j = (pp.first + z - start) % z;
+					if (j < count1)
+						discont[j] = pp.second;
+				}
+				this->continousHistoryEventsEvent = std::move(discont);
+			}
+			auto frames = [&](SizeListList& ll)
+			{
+				SizeListList ll1;
+				ll1.reserve(z1);
+				for (std::size_t j = 0; j < count1 && (start+j)%z < ll.size(); j++)
+					ll1.push_back(std::move(ll[(start+j)%z]));
+				ll = std::move(ll1);
+			};
+			if (this->frameUnderlyingDynamicIs)
+				frames(this->historyFrameUnderlying);
+			if (this->frameHistoryDynamicIs)
+				frames(this->historyFrameHistory);
+			this->historySize = z1;
+			this->historyEvent = count1 % z1;
+			this->historyOverflow = count1 == z1;
+			this->historyGeneration++;
+			this->historySlicesRebuild();
+			if (this->logging)
+			{
+				LOG "resize\thistory size: " << z << "\tto: " << z1 << "\tevents: " << count1 << "\ttime: " << ((sec)(clk::now() - mark)).count() << "s" UNLOG
+			}
 		}
-		if (ok)
-		{		
-			std::size_t hsize = this->underlyingHistoryRepa.size();
-			out.write(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
-			if (ok && hsize) 
+	}
+	catch (const std::exception& e) 
+	{
+		LOG "resize error: " << e.what() UNLOG
+		ok = false;
+	}
+	return ok;
+}
+
+// the slices are computed in parallel under a shared lock and then applied under a brief exclusive lock
+// events updated in between are left as they are, and if the model or the history has changed the computation is repeated
+// with history frames or dynamic frames each event depends on the new slices of the earlier events, so the events are resliced in order under an exclusive lock
+bool Alignment::Active::reslice(std::size_t threadsSize, std::size_t mapCapacity)
+{
+	bool ok = true;
+	try 
+	{
+		auto mark = clk::now();
+		bool sequential = this->frameHistorys.size() || this->frameUnderlyingDynamicIs || this->frameHistoryDynamicIs;
+		std::size_t changed = 0;
+		std::size_t attempts = 0;
+		bool done = false;
+		while (ok && !sequential && !done)
+		{
+			if (attempts++ >= 3)
 			{
-				for (std::size_t h = 0; ok && h < hsize; h++)	
+				sequential = true;
+				break;
+			}
+			SizeList slices;
+			std::size_t generation = 0;
+			std::size_t z = 0;
+			std::size_t y = 0;
+			std::size_t eventA = 0;
+			{
+				ActiveLockGuard guard(this->mutex, this->lockStats, "reslice", true, true);
+				ok = ok && this->decomp && this->historySparse && this->historySize;
+				for (auto& hr : this->underlyingHistoryRepa)
+					ok = ok && hr && hr->size == this->historySize && hr->evient;
+				if (!ok)
 				{
-					auto& hr = this->underlyingHistoryRepa[h];
-					ok = ok && hr;
-					if (!ok)
+					LOG "reslice\terror: inconsistent history or no decomp set" UNLOG
+					break;
+				}
+				generation = this->decompGeneration;
+				z = this->historySize;
+				y = this->historyEvent;
+				eventA = this->underlyingEventUpdated;
+				std::size_t count = this->historyOverflow ? z : y;
+				slices.resize(count);
+				std::size_t t = threadsSize ? threadsSize : std::max((std::size_t)std::thread::hardware_concurrency(), (std::size_t)1);
+				t = std::max(std::min(t, count), (std::size_t)1);
+				std::size_t chunk = (count + t - 1) / t;
+				auto run = [&](std::size_t j0, std::size_t j1)
+				{
+					SizeUCharStructList jj;
+					ActiveVarValueMap mm;
+					SizeList ll;
+					for (std::size_t j = j0; j < j1; j++)
 					{
-						LOG "dump error:\tfailed to write undefined underlying history repa to file: " << pp.filename  UNLOG
-						break;
+						jj.clear();
+						this->classifyListVarValues(this->underlyingHistoryRepa, this->underlyingHistorySparse, j, true, j, jj);
+						this->eventPathSlice(jj, mapCapacity, mm, ll);
+						slices[j] = ll.size() ? ll.back() : 0;
 					}
-					if (this->historyOverflow)
-						historyRepasPersistent(*hr, out);
-					else
-						historyRepasPersistentInitial(*hr, this->historyEvent, out);
-				}
-			}		
-		}
-		if (ok)
-		{		
-			std::size_t hsize = this->underlyingHistorySparse.size();
-			out.write(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
-			if (ok && hsize) 
+				};
+				std::vector<std::thread> threads;
+				for (std::size_t j0 = chunk; j0 < count; j0 += chunk)
+					threads.push_back(std::thread(run, j0, std::min(j0 + chunk, count)));
+				run(0, std::min(chunk, count));
+				for (auto& th : threads)
+					th.join();
+			}
 			{
-				for (std::size_t h = 0; ok && h < hsize; h++)	
+				ActiveLockGuard guard(this->mutex, this->lockStats, "reslice apply");
+				if (generation != this->decompGeneration || z != this->historySize 
+					|| this->underlyingEventUpdated - eventA >= z)
+					continue;
+				// the events written since the computation, from y to the current historyEvent, are already sliced by the model
+				auto rs = this->historySparse->arr;
+				std::size_t fresh = eventA != this->underlyingEventUpdated ? (this->historyEvent + z - y) % z : 0;
+				if (eventA != this->underlyingEventUpdated && !fresh)
+					continue;
+				for (std::size_t j = 0; j < slices.size(); j++)
 				{
-					auto& hr = this->underlyingHistorySparse[h];
-					ok = ok && hr;
-					if (!ok)
+					if ((j + z - y) % z < fresh)
+						continue;
+					if (rs[j] != slices[j])
 					{
-						LOG "dump error:\tfailed to write undefined underlying history sparse to file: " << pp.filename  UNLOG
-						break;
+						rs[j] = slices[j];
+						changed++;
 					}
-					if (this->historyOverflow)
-						historySparseArraysPersistent(*hr, out);
-					else
-						historySparseArraysPersistentInitial(*hr, this->historyEvent, out);
 				}
-			}					
+				if (changed)
+					this->historySlicesRebuild();
+				done = true;
+			}
 		}
-		if (ok)
-		{		
-			std::size_t hsize = this->underlyingSlicesParent.size();
-			out.write(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
-			if (ok && hsize) 
+		if (ok && sequential)
+		{
+			ActiveLockGuard guard(this->mutex, this->lockStats, "reslice apply");
+			ok = ok && this->decomp && this->historySparse && this->historySize;
+			if (!ok)
 			{
-				for (auto& p : this->underlyingSlicesParent)	
+				LOG "reslice\terror: inconsistent history or no decomp set" UNLOG
+			}
+			if (ok)
+			{
+				auto z = this->historySize;
+				auto y = this->historyEvent;
+				auto rs = this->historySparse->arr;
+				SizeUCharStructList jj;
+				ActiveVarValueMap mm;
+				SizeList ll;
+				for (std::size_t i = this->historyOverflow ? 0 : z - y; i < z; i++)
 				{
-					out.write(reinterpret_cast<char*>((std::size_t*)&p.first), sizeof(std::size_t));
-					out.write(reinterpret_cast<char*>((std::size_t*)&p.second), sizeof(std::size_t));
+					auto j = (y + i) % z;
+					jj.clear();
+					this->eventListVarValues(j, true, jj);
+					this->eventPathSlice(jj, mapCapacity, mm, ll);
+					auto sliceA = ll.size() ? ll.back() : 0;
+					if (rs[j] != sliceA)
+					{
+						rs[j] = sliceA;
+						changed++;
+					}
 				}
-			}					
+				if (changed)
+					this->historySlicesRebuild();
+			}
+		}
+		if (ok && this->logging)
+		{
+			LOG "reslice\tevents changed: " << changed << "\tsequential: " << (sequential ? "true" : "false") << "\ttime: " << ((sec)(clk::now() - mark)).count() << "s" UNLOG
+		}
+	}
+	catch (const std::exception& e) 
+	{
+		LOG "reslice error: " << e.what() UNLOG
+		ok = false;
+	}
+	return ok;
+}
+
+// each scan examines up to scanMax fuds from the cursor, noting the event id at which the subtree of each parent slice was first seen empty
+// the fuds of a subtree that has stayed empty for emptyEvents are removed along with all of their descendants, leaving the parent as a leaf
+bool Alignment::Active::prune(ActivePruneParameters pp)
+{
+	bool ok = true;
+	try 
+	{
+		while (ok && !this->terminate)
+		{
+			auto mark = (ok && pp.logging) ? clk::now() : std::chrono::time_point<clk>();
+			bool wrapped = false;
+			std::size_t removed = 0;
+			{
+				ActiveLockGuard guard(this->mutex, this->lockStats, "prune");
+				ok = ok && this->decomp;
+				if (!ok)
+				{
+					LOG "prune\terror: no decomp set" UNLOG
+					break;
+				}
+				auto& dr = *this->decomp;
+				auto& vi = dr.mapVarInt();
+				auto& slices = this->historySlicesSetEvent;
+				auto& empties = this->pruneSlicesEmptyEvent;
+				bool cached = this->historySliceCachingIs && !this->historySliceCumulativeIs;
+				auto eventA = this->underlyingEventUpdated;
+				// the slices of the subtree of a slice, including itself
+				auto subtree = [&](std::size_t sliceA, SizeList& ll)
+				{
+					ll.clear();
+					ll.push_back(sliceA);
+					for (std::size_t i = 0; i < ll.size(); i++)
+					{
+						auto it = vi.find(ll[i]);
+						if (it != vi.end())
+							for (auto s : dr.fuds[it->second].children)
+								ll.push_back(s);
+					}
+				};
+				SizeList ll;
+				SizeSet parents;
+				if (this->pruneCursor >= dr.fuds.size())
+					this->pruneCursor = 0;
+				// the slices walked count towards scanMax as well as the fuds, and the walk of a subtree stops at its first
+				// non-empty slice, so that the scan of a high fud does not walk the whole model
+				std::size_t k = 0;
+				std::size_t steps = 0;
+				for (; k < pp.scanMax && steps < pp.scanMax && this->pruneCursor + k < dr.fuds.size(); k++)
+				{
+					auto sliceA = dr.fuds[this->pruneCursor + k].parent;
+					if (!sliceA)
+						continue;
+					bool empty = true;
+					if (cached)
+					{
+						auto it = this->historySlicesSize.find(sliceA);
+						empty = it == this->historySlicesSize.end() || !it->second;
+					}
+					ll.clear();
+					if (empty)
+						ll.push_back(sliceA);
+					for (std::size_t i = 0; empty && i < ll.size(); i++)
+					{
+						auto s = ll[i];
+						steps++;
+						if (!cached)
+						{
+							auto it = slices.find(s);
+							empty = it == slices.end() || !it->second.size();
+						}
+						empty = empty && !this->inducingSlices.count(s);
+						auto it = vi.find(s);
+						if (empty && it != vi.end())
+							for (auto s1 : dr.fuds[it->second].children)
+								ll.push_back(s1);
+					}
+					if (!empty)
+					{
+						empties.erase(sliceA);
+						continue;
+					}
+					auto it = empties.find(sliceA);
+					if (it == empties.end())
+						empties.insert_or_assign(sliceA, eventA);
+					else if (eventA >= it->second + pp.emptyEvents)
+						parents.insert(sliceA);
+				}
+				this->pruneCursor += k;
+				wrapped = this->pruneCursor >= dr.fuds.size();
+				// remove the fuds of the subtrees and fix up the maps and caches
+				if (parents.size())
+				{
+					SizeSet slicesRemoved;
+					SizeUSet fudsRemoved;
+					for (auto sliceA : parents)
+					{
+						subtree(sliceA, ll);
+						for (auto s : ll)
+						{
+							auto it = vi.find(s);
+							if (it != vi.end())
+								fudsRemoved.insert(it->second);
+							if (s != sliceA)
+								slicesRemoved.insert(s);
+						}
+					}
+					auto& cv = dr.mapVarParent();
+					std::vector<FudSlicedStruct> fuds;
+					fuds.reserve(dr.fuds.size() - fudsRemoved.size());
+					for (std::size_t i = 0; i < dr.fuds.size(); i++)
+						if (fudsRemoved.count(i))
+						{
+							dr.fudRepasSize -= dr.fuds[i].fud.size();
+							this->sliceIndicators.erase(dr.fuds[i].parent);
+							this->pruneSlicesEmptyEvent.erase(dr.fuds[i].parent);
+						}
+						else
+							fuds.push_back(std::move(dr.fuds[i]));
+					dr.fuds = std::move(fuds);
+					this->decompGeneration++;
+					vi.clear();
+					for (std::size_t i = 0; i < dr.fuds.size(); i++)
+						vi[dr.fuds[i].parent] = i;
+					for (auto s : slicesRemoved)
+					{
+						cv.erase(s);
+						slices.erase(s);
+						this->induceSlices.erase(s);
+						this->induceSliceFailsSize.erase(s);
+						this->historySlicesSize.erase(s);
+						this->historySlicesLength.erase(s);
+						this->historySlicesSlicesSizeNext.erase(s);
+						this->historySlicesSliceSetPrev.erase(s);
+						this->pruneSlicesEmptyEvent.erase(s);
+					}
+					for (auto& p : this->historySlicesSlicesSizeNext)
+						for (auto s : slicesRemoved)
+							p.second.erase(s);
+					for (auto& p : this->historySlicesSliceSetPrev)
+						for (auto s : slicesRemoved)
+							p.second.erase(s);
+					// the parents are now leaves that may be induced again
+					for (auto sliceA : parents)
+						this->induceSliceFailsSize.erase(sliceA);
+					if (this->transitionIndexIs && fudsRemoved.size())
+						this->transitionIndex.build(this->historySlicesSlicesSizeNext);
+					removed = fudsRemoved.size();
+					this->pruneCursor = wrapped ? 0 : std::min(this->pruneCursor, dr.fuds.size());
+				}
+				if (ok && pp.logging && (removed || wrapped))
+				{
+					LOG "prune\tfuds removed: " << removed << "\tfud cardinality: " << dr.fuds.size() << "\tmodel cardinality: " << dr.fudRepasSize << "\ttime: " << ((sec)(clk::now() - mark)).count() << "s" UNLOG
+				}
+			}
+			if (!pp.interval && wrapped)
+				break;
+			if (pp.interval)
+				std::this_thread::sleep_for(std::chrono::milliseconds(pp.interval));
+		}
+	} 
+	catch (const std::exception& e) 
+	{
+		LOG "prune error: " << e.what()  UNLOG
+		ok = false;
+	}
+	if (!ok)
+		this->terminate = true;
+	
+	return ok;
+}
+
+bool Alignment::Active::dump(const ActiveIOParameters& pp)
+{
+	bool ok = true;
+	
+	std::ofstream out;
+	try 
+	{
+		auto mark = (ok && this->logging) ? clk::now() : std::chrono::time_point<clk>();
+		out.exceptions(out.failbit | out.badbit);
+		if (this->arena)
+		{
+			ActiveLockGuard guard(this->mutex, this->lockStats, "dump compact");
+			this->arenaCompact(false);
+		}
+		ActiveLockGuard guard(this->mutex, this->lockStats, "dump", true, true);
+		out.open(pp.filename, std::ios::binary);
+		if (ok)
+		{		
+			std::size_t h = this->name.size();
+			out.write(reinterpret_cast<char*>(&h), sizeof(std::size_t));
+			out.write(reinterpret_cast<char*>((char*)this->name.data()), h);
+		}
+		if (ok)
+		{
+			std::size_t h = 1;
+			out.write(reinterpret_cast<char*>(&h), sizeof(std::size_t));
+			out.write(reinterpret_cast<char*>(&this->underlyingEventUpdated), sizeof(std::size_t));
+		}
+		if (ok)
+		{		
+			out.write(reinterpret_cast<char*>(&this->historySize), sizeof(std::size_t));
+			out.write(reinterpret_cast<char*>(&this->historyOverflow), 1);
+			out.write(reinterpret_cast<char*>(&this->historyEvent), sizeof(std::size_t));
+		}
+		if (ok)
+		{		
+			std::size_t hsize = this->underlyingHistoryRepa.size();
+			out.write(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+			if (ok && hsize) 
+			{
+				for (std::size_t h = 0; ok && h < hsize; h++)	
+				{
+					auto& hr = this->underlyingHistoryRepa[h];
+					ok = ok && hr;
+					if (!ok)
+					{
+						LOG "dump error:\tfailed to write undefined underlying history repa to file: " << pp.filename  UNLOG
+						break;
+					}
+					if (this->historyOverflow)
+						historyRepasPersistent(*hr, out);
+					else
+						historyRepasPersistentInitial(*hr, this->historyEvent, out);
+				}
+			}		
+		}
+		if (ok)
+		{		
+			std::size_t hsize = this->underlyingHistorySparse.size();
+			out.write(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+			if (ok && hsize) 
+			{
+				for (std::size_t h = 0; ok && h < hsize; h++)	
+				{
+					auto& hr = this->underlyingHistorySparse[h];
+					ok = ok && hr;
+					if (!ok)
+					{
+						LOG "dump error:\tfailed to write undefined underlying history sparse to file: " << pp.filename  UNLOG
+						break;
+					}
+					if (this->historyOverflow)
+						historySparseArraysPersistent(*hr, out);
+					else
+						historySparseArraysPersistentInitial(*hr, this->historyEvent, out);
+				}
+			}					
+		}
+		if (ok)
+		{		
+			std::size_t hsize = this->underlyingSlicesParent.size();
+			out.write(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+			if (ok && hsize) 
+			{
+				for (auto& p : this->underlyingSlicesParent)	
+				{
+					out.write(reinterpret_cast<char*>((std::size_t*)&p.first), sizeof(std::size_t));
+					out.write(reinterpret_cast<char*>((std::size_t*)&p.second), sizeof(std::size_t));
+				}
+			}					
 		}
 		if (ok)
 		{		
-			bool has = this->decomp ? true : false;
+			// 2 if the decomp is followed by compact slices
+			unsigned char has = this->decomp ? (this->sliceIndicators.size() ? 2 : 1) : 0;
 			out.write(reinterpret_cast<char*>(&has), 1);
 			if (ok && has) 
 				decompFudSlicedRepasPersistent(*this->decomp, out);
+			if (ok && has == 2)
+			{
+				std::size_t hsize = this->sliceIndicators.size();
+				out.write(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+				for (auto& p : this->sliceIndicators)	
+				{
+					auto& si = p.second;
+					out.write(reinterpret_cast<char*>((std::size_t*)&p.first), sizeof(std::size_t));
+					std::size_t m = si.vars.size();
+					out.write(reinterpret_cast<char*>(&m), sizeof(std::size_t));
+					out.write(reinterpret_cast<char*>(si.vars.data()), m*sizeof(std::size_t));
+					out.write(reinterpret_cast<char*>(si.shape.data()), m*sizeof(std::size_t));
+					out.write(reinterpret_cast<char*>(&si.remainder), sizeof(std::size_t));
+					std::size_t msize = si.indexChild.size();
+					out.write(reinterpret_cast<char*>(&msize), sizeof(std::size_t));
+					for (auto& q : si.indexChild)	
+					{
+						out.write(reinterpret_cast<char*>((std::size_t*)&q.first), sizeof(std::size_t));
+						out.write(reinterpret_cast<char*>((std::size_t*)&q.second), sizeof(std::size_t));
+					}
+				}
+			}
 		}
 		if (ok)
 		{		
@@ -2426,7 +4646,7 @@ bool Alignment::Active::load(const ActiveIOParameters& pp)
 	{
 		auto mark = (ok && this->logging) ? clk::now() : std::chrono::time_point<clk>();
 		in.exceptions(in.failbit | in.badbit | in.eofbit);
-		std::lock_guard<std::mutex> guard(this->mutex);	
+		ActiveLockGuard guard(this->mutex, this->lockStats, "load");	
 		in.open(pp.filename, std::ios::binary);
 		if (ok)
 		{		
@@ -2514,14 +4734,47 @@ bool Alignment::Active::load(const ActiveIOParameters& pp)
 		}		
 		if (ok)
 		{		
-			bool has = false;
+			unsigned char has = 0;
 			in.read(reinterpret_cast<char*>(&has), 1);
 			this->decomp.reset();
+			this->sliceIndicators.clear();
 			if (ok && has)
 			{
 				this->decomp = persistentsDecompFudSlicedRepa(in);	
+				this->decompGeneration++;
+				this->historyGeneration++;
 				this->decomp->mapVarInt();
 				this->decomp->mapVarParent();
+				this->arenaCompact();
+			}
+			if (ok && has == 2)
+			{
+				std::size_t hsize = 0;
+				in.read(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+				for (std::size_t h = 0; h < hsize; h++)
+				{
+					std::size_t sliceA = 0;
+					in.read(reinterpret_cast<char*>(&sliceA), sizeof(std::size_t));
+					auto& si = this->sliceIndicators[sliceA];
+					std::size_t m = 0;
+					in.read(reinterpret_cast<char*>(&m), sizeof(std::size_t));
+					si.vars.resize(m);
+					si.shape.resize(m);
+					in.read(reinterpret_cast<char*>(si.vars.data()), m*sizeof(std::size_t));
+					in.read(reinterpret_cast<char*>(si.shape.data()), m*sizeof(std::size_t));
+					in.read(reinterpret_cast<char*>(&si.remainder), sizeof(std::size_t));
+					std::size_t msize = 0;
+					in.read(reinterpret_cast<char*>(&msize), sizeof(std::size_t));
+					si.indexChild.reserve(msize);
+					for (std::size_t i = 0; i < msize; i++)
+					{
+						std::size_t k = 0;
+						std::size_t v = 0;
+						in.read(reinterpret_cast<char*>(&k), sizeof(std::size_t));
+						in.read(reinterpret_cast<char*>(&v), sizeof(std::size_t));
+						si.indexChild[k] = v;
+					}
+				}
 			}
 		}
 		if (ok)
@@ -2840,57 +5093,11 @@ bool Alignment::Active::load(const ActiveIOParameters& pp)
 		// cache sizes and transitions
 		if (ok && historySliceCachingIs && !this->historySliceCumulativeIs 
 			&& this->decomp && this->historySparse)
-		{
-			auto over = this->historyOverflow;
-			auto cont = this->continousIs;
-			auto& discont = this->continousHistoryEventsEvent;
-			auto z = this->historySize;
-			auto y = this->historyEvent;
-			auto rs = this->historySparse->arr;
-			auto& slices = this->historySlicesSetEvent;
-			auto& sizes = this->historySlicesSize;
-			auto& nexts = this->historySlicesSlicesSizeNext;
-			auto& prevs = this->historySlicesSliceSetPrev;
-			auto& cv = this->decomp->mapVarParent();
-			sizes.clear();
-			nexts.clear();
-			prevs.clear();
-			sizes.reserve(slices.size()*3);
-			nexts.reserve(slices.size());
-			prevs.reserve(slices.size());
-			for (auto pp : slices)
-			{
-				auto sliceC = pp.first;
-				auto a = pp.second.size();
-				while (true)
-				{
-					sizes[sliceC] += a;
-					if (!sliceC)
-						break;
-					sliceC = cv[sliceC];
-				}								
-			}	
-			if (cont)
-			{
-				auto j = over ? y : z;	
-				auto sliceB = rs[j%z];
-				j++;
-				while (j < y+z)
-				{
-					auto sliceC = rs[j%z];
-					if (sliceC != sliceB)
-					{
-						if (!discont.count(j%z))
-						{
-							nexts[sliceB][sliceC]++;
-							prevs[sliceC].insert(sliceB);
-						}
-						sliceB = sliceC;
-					}
-					j++;
-				}					
-			}
-		}	
+			this->historySlicesCache();
+		if (ok && this->transitionIndexIs)
+			this->transitionIndex.build(this->historySlicesSlicesSizeNext);
+		if (ok && this->induceCountsIs && this->historySparse)
+			this->slicesCountsRebuild();
 		{
 		// // trace sizes and transitions
 		// if (ok && historySliceCachingIs)
@@ -2954,3 +5161,981 @@ bool Alignment::Active::load(const ActiveIOParameters& pp)
 	return ok;
 }
 
+
+void recordWriteSizeList(const SizeList& ll, std::ostream& out)
+{
+	std::size_t hsize = ll.size();
+	out.write(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+	for (auto v : ll)	
+		out.write(reinterpret_cast<char*>((std::size_t*)&v), sizeof(std::size_t));
+}
+
+void recordReadSizeList(SizeList& ll, std::istream& in)
+{
+	std::size_t hsize = 0;
+	in.read(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+	ll.clear();
+	ll.reserve(hsize);
+	for (std::size_t i = 0; i < hsize; i++)
+	{
+		std::size_t v = 0;
+		in.read(reinterpret_cast<char*>(&v), sizeof(std::size_t));
+		ll.push_back(v);
+	}
+}
+
+void recordWriteInduceParameters(const ActiveInduceParameters& pp, std::ostream& out)
+{
+	std::size_t ll[] = {pp.tint, pp.wmax, pp.lmax, pp.xmax, pp.omax, pp.bmax, pp.mmax, pp.umax, pp.pmax, pp.mult, pp.seed};
+	out.write(reinterpret_cast<char*>(ll), sizeof(ll));
+	double rr[] = {pp.znnmax, pp.diagonalMin};
+	out.write(reinterpret_cast<char*>(rr), sizeof(rr));
+	recordWriteSizeList(SizeList(pp.induceThresholds.begin(), pp.induceThresholds.end()), out);
+}
+
+void recordReadInduceParameters(ActiveInduceParameters& pp, std::istream& in)
+{
+	std::size_t ll[11];
+	in.read(reinterpret_cast<char*>(ll), sizeof(ll));
+	pp.tint = ll[0];
+	pp.wmax = ll[1];
+	pp.lmax = ll[2];
+	pp.xmax = ll[3];
+	pp.omax = ll[4];
+	pp.bmax = ll[5];
+	pp.mmax = ll[6];
+	pp.umax = ll[7];
+	pp.pmax = ll[8];
+	pp.mult = ll[9];
+	pp.seed = ll[10];
+	double rr[2];
+	in.read(reinterpret_cast<char*>(rr), sizeof(rr));
+	pp.znnmax = rr[0];
+	pp.diagonalMin = rr[1];
+	SizeList tt;
+	recordReadSizeList(tt, in);
+	pp.induceThresholds = std::set<std::size_t>(tt.begin(), tt.end());
+}
+
+const char recordMagic[] = "ACTREC01";
+
+// the header holds the underlying repa variables and shapes so that an update record with unchanged variables is only the event ids and values
+bool Alignment::Active::recordStart(const ActiveIOParameters& pp)
+{
+	bool ok = true;
+	
+	try 
+	{
+		ActiveLockGuard guard(this->mutex, this->lockStats, "record");
+		auto recorderA = std::make_unique<ActiveRecorder>();
+		auto& out = recorderA->out;
+		out.exceptions(out.failbit | out.badbit);
+		out.open(pp.filename, std::ios::binary);
+		out.write(recordMagic, 8);
+		{		
+			std::size_t h = this->name.size();
+			out.write(reinterpret_cast<char*>(&h), sizeof(std::size_t));
+			out.write(reinterpret_cast<char*>((char*)this->name.data()), h);
+		}
+		out.write(reinterpret_cast<char*>(&this->historySize), sizeof(std::size_t));
+		out.write(reinterpret_cast<char*>(&this->bits), sizeof(int));
+		out.write(reinterpret_cast<char*>(&this->induceThreshold), sizeof(std::size_t));
+		out.write(reinterpret_cast<char*>(&this->underlyingEventUpdated), sizeof(std::size_t));
+		recordWriteSizeList(this->frameUnderlyings, out);
+		recordWriteSizeList(this->frameHistorys, out);
+		out.write(reinterpret_cast<char*>(&this->underlyingOffsetIs), 1);
+		recordWriteSizeList(SizeList(this->induceVarComputeds.begin(), this->induceVarComputeds.end()), out);
+		recordWriteSizeList(SizeList(this->induceVarExclusions.begin(), this->induceVarExclusions.end()), out);
+		{
+			std::size_t hsize = this->underlyingHistoryRepa.size();
+			out.write(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+			for (auto& hr : this->underlyingHistoryRepa)
+			{
+				ok = ok && hr;
+				if (!ok)
+				{
+					LOG "record error:\tfailed to write undefined underlying history repa to file: " << pp.filename  UNLOG
+					break;
+				}
+				auto n = hr->dimension;
+				HistoryRepa hr1;
+				hr1.dimension = n;
+				hr1.vectorVar = new std::size_t[n];
+				hr1.shape = new std::size_t[n];
+				for (std::size_t i = 0; i < n; i++)
+				{
+					hr1.vectorVar[i] = hr->vectorVar[i];
+					hr1.shape[i] = hr->shape[i];
+				}
+				hr1.size = 1;
+				hr1.evient = true;
+				hr1.arr = new unsigned char[n];
+				std::memset(hr1.arr, 0, n);
+				historyRepasPersistent(hr1, out);
+			}
+		}
+		{
+			std::size_t hsize = this->underlyingHistorySparse.size();
+			out.write(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+		}
+		if (ok)
+		{
+			recorderA->start = std::chrono::steady_clock::now();
+			this->recorder = std::move(recorderA);
+		}
+		if (ok && this->logging)
+		{
+			LOG "record start\tfile name: " << pp.filename UNLOG
+		}	
+	} 
+	catch (const std::exception& e) 
+	{
+		LOG "record error:\tfailed to start recording to file: " << pp.filename << "\terror message: " << e.what()  UNLOG
+		ok = false;
+	}
+	
+	return ok;
+}
+
+bool Alignment::Active::recordStop()
+{
+	bool ok = true;
+	
+	try 
+	{
+		ActiveLockGuard guard(this->mutex, this->lockStats, "record");
+		if (this->recorder)
+		{
+			auto updates = this->recorder->updates;
+			this->recorder->out.close();
+			this->recorder.reset();
+			if (this->logging)
+			{
+				LOG "record stop\tupdates: " << updates UNLOG
+			}	
+		}
+	} 
+	catch (const std::exception& e) 
+	{
+		LOG "record error:\tfailed to stop recording\terror message: " << e.what()  UNLOG
+		this->recorder.reset();
+		ok = false;
+	}
+	
+	return ok;
+}
+
+// called by update with the mutex locked, a write failure stops the recording but not the active
+void Alignment::Active::recordUpdate()
+{
+	try 
+	{
+		auto& out = this->recorder->out;
+		char type = 'U';
+		out.write(&type, 1);
+		std::size_t t = (std::size_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->recorder->start).count();
+		out.write(reinterpret_cast<char*>(&t), sizeof(std::size_t));
+		{
+			std::size_t hsize = this->underlyingEventsRepa.size();
+			out.write(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+			for (std::size_t h = 0; h < hsize; h++)
+			{
+				auto& ev = *this->underlyingEventsRepa[h];
+				auto& hr = *this->underlyingHistoryRepa[h];
+				auto& hr1 = *ev.state;
+				out.write(reinterpret_cast<char*>(&ev.id), sizeof(std::size_t));
+				bool equiv = hr.dimension == hr1.dimension;
+				for (std::size_t i = 0; equiv && i < hr.dimension; i++)
+					equiv = equiv && hr.vectorVar[i] == hr1.vectorVar[i];
+				char flag = equiv ? 0 : 1;
+				out.write(&flag, 1);
+				if (equiv)
+				{
+					if (hr1.evient)
+						out.write(reinterpret_cast<char*>(hr1.arr), hr1.dimension);
+					else
+						for (std::size_t i = 0; i < hr1.dimension; i++)
+							out.write(reinterpret_cast<char*>(hr1.arr + i*hr1.size), 1);
+				}
+				else
+					historyRepasPersistent(hr1, out);
+			}
+		}
+		{
+			std::size_t hsize = this->underlyingEventsSparse.size();
+			out.write(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+			for (auto& ev : this->underlyingEventsSparse)
+			{
+				out.write(reinterpret_cast<char*>(&ev->id), sizeof(std::size_t));
+				char flag = ev->state ? 1 : 0;
+				out.write(&flag, 1);
+				if (ev->state)
+					historySparseArraysPersistent(*ev->state, out);
+			}
+		}
+		this->recorder->updates++;
+	} 
+	catch (const std::exception& e) 
+	{
+		LOG "record error:\tfailed to record update\terror message: " << e.what()  UNLOG
+		this->recorder.reset();
+	}
+}
+
+// called by induce with the mutex locked after the commit or fail
+void Alignment::Active::recordInduce(std::size_t sliceA, std::size_t sliceSizeA, bool fail, double duration, const ActiveInduceParameters& pp)
+{
+	try 
+	{
+		auto& out = this->recorder->out;
+		char type = 'I';
+		out.write(&type, 1);
+		std::size_t t = (std::size_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->recorder->start).count();
+		out.write(reinterpret_cast<char*>(&t), sizeof(std::size_t));
+		out.write(reinterpret_cast<char*>(&this->recorder->updates), sizeof(std::size_t));
+		out.write(reinterpret_cast<char*>(&sliceA), sizeof(std::size_t));
+		out.write(reinterpret_cast<char*>(&sliceSizeA), sizeof(std::size_t));
+		out.write(reinterpret_cast<char*>(&fail), 1);
+		out.write(reinterpret_cast<char*>(&duration), sizeof(double));
+		recordWriteInduceParameters(pp, out);
+	} 
+	catch (const std::exception& e) 
+	{
+		LOG "record error:\tfailed to record induce\terror message: " << e.what()  UNLOG
+		this->recorder.reset();
+	}
+}
+
+bool Alignment::ActiveRecordReader::open(const std::string& filename)
+{
+	bool ok = true;
+	
+	try 
+	{
+		in.exceptions(in.failbit | in.badbit | in.eofbit);
+		in.open(filename, std::ios::binary);
+		char magic[8];
+		in.read(magic, 8);
+		ok = ok && std::memcmp(magic, recordMagic, 8) == 0;
+		if (!ok)
+			return ok;
+		auto& hh = this->header;
+		{
+			std::size_t h = 0;
+			in.read(reinterpret_cast<char*>(&h), sizeof(std::size_t));
+			hh.name = std::string(h,' ');
+			if (h)
+				in.read(reinterpret_cast<char*>((char*)hh.name.data()), h);
+		}
+		in.read(reinterpret_cast<char*>(&hh.historySize), sizeof(std::size_t));
+		in.read(reinterpret_cast<char*>(&hh.bits), sizeof(int));
+		in.read(reinterpret_cast<char*>(&hh.induceThreshold), sizeof(std::size_t));
+		in.read(reinterpret_cast<char*>(&hh.underlyingEventUpdated), sizeof(std::size_t));
+		recordReadSizeList(hh.frameUnderlyings, in);
+		recordReadSizeList(hh.frameHistorys, in);
+		in.read(reinterpret_cast<char*>(&hh.underlyingOffsetIs), 1);
+		recordReadSizeList(hh.induceVarComputeds, in);
+		recordReadSizeList(hh.induceVarExclusions, in);
+		{
+			std::size_t hsize = 0;
+			in.read(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+			hh.underlyingRepa.clear();
+			for (std::size_t h = 0; h < hsize; h++)
+				hh.underlyingRepa.push_back(persistentsHistoryRepa(in));
+		}
+		in.read(reinterpret_cast<char*>(&hh.underlyingSparseSize), sizeof(std::size_t));
+	} 
+	catch (const std::exception&) 
+	{
+		ok = false;
+	}
+	
+	return ok;
+}
+
+bool Alignment::ActiveRecordReader::next(ActiveRecord& record)
+{
+	bool ok = true;
+	
+	if (this->bad)
+		return false;
+	try 
+	{
+		// the end of the recording is only clean between records
+		in.exceptions(in.badbit);
+		bool end = in.peek() == std::char_traits<char>::eof();
+		if (end)
+			return false;
+		in.exceptions(in.failbit | in.badbit | in.eofbit);
+		in.read(&record.type, 1);
+		in.read(reinterpret_cast<char*>(&record.time), sizeof(std::size_t));
+		if (record.type == 'U')
+		{
+			{
+				std::size_t hsize = 0;
+				in.read(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+				ok = ok && hsize == this->header.underlyingRepa.size();
+				if (!ok)
+					return ok;
+				record.eventsRepa.resize(hsize);
+				for (std::size_t h = 0; h < hsize; h++)
+				{
+					auto& ev = record.eventsRepa[h];
+					if (!ev)
+						ev = std::make_shared<ActiveEventRepa>();
+					in.read(reinterpret_cast<char*>(&ev->id), sizeof(std::size_t));
+					char flag = 0;
+					in.read(&flag, 1);
+					if (flag == 0)
+					{
+						auto& hr = *this->header.underlyingRepa[h];
+						auto n = hr.dimension;
+						bool equiv = ev->state && ev->state->dimension == n && ev->state->size == 1 && ev->state->evient;
+						for (std::size_t i = 0; equiv && i < n; i++)
+							equiv = equiv && ev->state->vectorVar[i] == hr.vectorVar[i];
+						if (!equiv)
+						{
+							auto hr1 = std::make_shared<HistoryRepa>();
+							hr1->dimension = n;
+							hr1->vectorVar = new std::size_t[n];
+							hr1->shape = new std::size_t[n];
+							for (std::size_t i = 0; i < n; i++)
+							{
+								hr1->vectorVar[i] = hr.vectorVar[i];
+								hr1->shape[i] = hr.shape[i];
+							}
+							hr1->size = 1;
+							hr1->evient = true;
+							hr1->arr = new unsigned char[n];
+							ev->state = hr1;
+						}
+						in.read(reinterpret_cast<char*>(ev->state->arr), n);
+					}
+					else
+						ev->state = persistentsHistoryRepa(in);
+				}
+			}
+			{
+				std::size_t hsize = 0;
+				in.read(reinterpret_cast<char*>(&hsize), sizeof(std::size_t));
+				record.eventsSparse.resize(hsize);
+				for (std::size_t h = 0; h < hsize; h++)
+				{
+					auto& ev = record.eventsSparse[h];
+					if (!ev)
+						ev = std::make_shared<ActiveEventSparse>();
+					in.read(reinterpret_cast<char*>(&ev->id), sizeof(std::size_t));
+					char flag = 0;
+					in.read(&flag, 1);
+					if (flag)
+						ev->state = persistentsHistorySparseArray(in);
+					else
+						ev->state.reset();
+				}
+			}
+		}
+		else if (record.type == 'I')
+		{
+			in.read(reinterpret_cast<char*>(&record.updates), sizeof(std::size_t));
+			in.read(reinterpret_cast<char*>(&record.slice), sizeof(std::size_t));
+			in.read(reinterpret_cast<char*>(&record.sliceSize), sizeof(std::size_t));
+			in.read(reinterpret_cast<char*>(&record.fail), 1);
+			in.read(reinterpret_cast<char*>(&record.duration), sizeof(double));
+			recordReadInduceParameters(record.induceParameters, in);
+		}
+		else
+			ok = false;
+	} 
+	catch (const std::exception&) 
+	{
+		ok = false;
+	}
+	if (!ok)
+		this->bad = true;
+	
+	return ok;
+}
+
+ActiveHierarchyQueue::ActiveHierarchyQueue(std::size_t capacityA) : capacity(capacityA ? capacityA : 1), closed(false)
+{
+}
+
+bool Alignment::ActiveHierarchyQueue::push(ActiveHierarchyEventPtr ev)
+{
+	std::unique_lock<std::mutex> guard(this->mutex);
+	this->notFull.wait(guard, [this]{return this->closed || this->events.size() < this->capacity;});
+	if (this->closed)
+		return false;
+	this->events.push_back(std::move(ev));
+	guard.unlock();
+	this->notEmpty.notify_one();
+	return true;
+}
+
+bool Alignment::ActiveHierarchyQueue::pop(ActiveHierarchyEventPtr& ev)
+{
+	std::unique_lock<std::mutex> guard(this->mutex);
+	this->notEmpty.wait(guard, [this]{return this->closed || this->events.size();});
+	if (!this->events.size())
+		return false;
+	ev = std::move(this->events.front());
+	this->events.pop_front();
+	guard.unlock();
+	this->notFull.notify_one();
+	return true;
+}
+
+void Alignment::ActiveHierarchyQueue::close()
+{
+	{
+		std::lock_guard<std::mutex> guard(this->mutex);
+		this->closed = true;
+	}
+	this->notFull.notify_all();
+	this->notEmpty.notify_all();
+}
+
+ActiveHierarchy::ActiveHierarchy(std::size_t queueCapacityA) : queueCapacity(queueCapacityA), failed(false)
+{
+}
+
+ActiveHierarchy::~ActiveHierarchy()
+{
+	this->stop();
+}
+
+void run_hierarchy_induce(Active& active, ActiveInduceParameters pp, ActiveUpdateParameters ppu)
+{
+	active.induce(pp, ppu);
+	return;
+};
+
+bool Alignment::ActiveHierarchy::start()
+{
+	bool ok = !this->threads.size();
+	for (std::size_t k = 0; ok && k < this->levels.size(); k++)
+	{
+		auto& level = this->levels[k];
+		ok = ok && level.active;
+		ok = ok && (!k || level.underlyingIndex < level.active->underlyingEventsSparse.size());
+		ok = ok && (k+1 == this->levels.size() || level.active->eventSparse);
+	}
+	if (!ok)
+		return ok;
+	this->failed = false;
+	this->queues.clear();
+	for (std::size_t k = 0; k < this->levels.size(); k++)
+		this->queues.push_back(std::make_unique<ActiveHierarchyQueue>(this->queueCapacity));
+	for (std::size_t k = 0; k < this->levels.size(); k++)
+	{
+		auto& level = this->levels[k];
+		if (level.induceIs && level.induceParameters.asyncThreadMax)
+			this->induceThreads.push_back(std::thread(run_hierarchy_induce, std::ref(*level.active), level.induceParameters, level.updateParameters));
+	}
+	for (std::size_t k = 0; k < this->levels.size(); k++)
+		this->threads.push_back(std::thread(&ActiveHierarchy::run, this, k));
+	return ok;
+}
+
+bool Alignment::ActiveHierarchy::push(std::vector<ActiveEventRepaPtr> eventsRepa, std::vector<ActiveEventSparsePtr> eventsSparse)
+{
+	if (this->failed || !this->queues.size())
+		return false;
+	auto ev = std::make_shared<ActiveHierarchyEvent>();
+	ev->eventsRepa = std::move(eventsRepa);
+	ev->eventsSparse = std::move(eventsSparse);
+	return this->queues.front()->push(std::move(ev));
+}
+
+bool Alignment::ActiveHierarchy::stop()
+{
+	if (this->queues.size())
+		this->queues.front()->close();
+	for (auto& t : this->threads)
+		t.join();
+	this->threads.clear();
+	if (this->induceThreads.size())
+	{
+		for (auto& level : this->levels)
+			if (level.induceIs && level.induceParameters.asyncThreadMax)
+				level.active->terminate = true;
+		for (auto& t : this->induceThreads)
+			t.join();
+		this->induceThreads.clear();
+	}
+	this->queues.clear();
+	return !this->failed;
+}
+
+// each level pops its queue, updates and pushes its eventSparse to the level above
+// on failure all of the queues are closed so that the other levels and the caller do not block
+void Alignment::ActiveHierarchy::run(std::size_t k)
+{
+	auto& level = this->levels[k];
+	auto& active = *level.active;
+	auto& queue = *this->queues[k];
+	bool top = k+1 == this->levels.size();
+	bool ok = true;
+	std::size_t updates = 0;
+	ActiveHierarchyEventPtr ev;
+	// the events pushed to the level above, with their sparse events, are reused in turn once the level above has released them
+	std::vector<ActiveHierarchyEventPtr> pushed;
+	std::size_t pushedNext = 0;
+	while (ok && !this->failed && queue.pop(ev))
+	{
+		if (!k)
+		{
+			active.underlyingEventsRepa = ev->eventsRepa;
+			active.underlyingEventsSparse = ev->eventsSparse;
+		}
+		else
+			active.underlyingEventsSparse[level.underlyingIndex] = ev->eventsSparse.front();
+		while (active.updateProhibit && !active.terminate)
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		ok = ok && active.update(level.updateParameters);
+		updates++;
+		if (ok && level.induceIs && !level.induceParameters.asyncThreadMax 
+			&& level.induceInterval && updates % level.induceInterval == 0)
+			ok = ok && active.induce(level.induceParameters, level.updateParameters);
+		if (ok && !top)
+		{
+			ActiveHierarchyEventPtr ev1;
+			if (pushed.size())
+			{
+				auto& ev2 = pushed[pushedNext];
+				if (ev2.use_count() == 1 && ev2->eventsSparse.front().use_count() == 1)
+				{
+					std::atomic_thread_fence(std::memory_order_acquire);
+					ev1 = ev2;
+					pushedNext = (pushedNext + 1) % pushed.size();
+				}
+			}
+			if (!ev1)
+			{
+				ev1 = std::make_shared<ActiveHierarchyEvent>();
+				ev1->eventsSparse.push_back(std::make_shared<ActiveEventSparse>());
+				if (pushed.size() < this->queueCapacity + 2)
+				{
+					pushed.insert(pushed.begin() + pushedNext, ev1);
+					pushedNext = (pushedNext + 1) % pushed.size();
+				}
+			}
+			*ev1->eventsSparse.front() = active.eventSparseRead();
+			ok = ok && this->queues[k+1]->push(ev1);
+		}
+	}
+	if (!ok)
+	{
+		this->failed = true;
+		for (auto& q : this->queues)
+			q->close();
+	}
+	else if (!top)
+		this->queues[k+1]->close();
+}
+
+ActiveExecutor::ActiveExecutor(std::size_t threadMaxA, std::size_t induceThreadMaxA) : threadMax(threadMaxA ? threadMaxA : 1), induceThreadMax(induceThreadMaxA), queueCapacity(1024), batch(16), induceInterval(10), running(0), inducing(0), terminate(false), failed(false)
+{
+}
+
+ActiveExecutor::~ActiveExecutor()
+{
+	this->stop();
+}
+
+std::size_t Alignment::ActiveExecutor::add(Active& active, ActiveUpdateParameters ppu, bool induceIs, ActiveInduceParameters ppi)
+{
+	auto inst = std::make_unique<ActiveExecutorInstance>();
+	inst->active = &active;
+	inst->updateParameters = ppu;
+	inst->induceIs = induceIs;
+	inst->induceParameters = ppi;
+	std::lock_guard<std::mutex> guard(this->mutex);
+	this->instances.push_back(std::move(inst));
+	return this->instances.size() - 1;
+}
+
+bool Alignment::ActiveExecutor::start()
+{
+	std::lock_guard<std::mutex> guard(this->mutex);
+	if (this->threads.size())
+		return false;
+	this->terminate = false;
+	// at least one thread is kept for updates, so that queued events are not stalled behind long inductions
+	if (!this->threadMax)
+		this->threadMax = 1;
+	this->induceThreadMax = std::min(this->induceThreadMax, this->threadMax - 1);
+	for (std::size_t t = 0; t < this->threadMax; t++)
+		this->threads.push_back(std::thread(&ActiveExecutor::run, this));
+	return true;
+}
+
+bool Alignment::ActiveExecutor::post(std::size_t instance, std::vector<ActiveEventRepaPtr> eventsRepa, std::vector<ActiveEventSparsePtr> eventsSparse)
+{
+	auto ev = std::make_shared<ActiveHierarchyEvent>();
+	ev->eventsRepa = std::move(eventsRepa);
+	ev->eventsSparse = std::move(eventsSparse);
+	std::unique_lock<std::mutex> guard(this->mutex);
+	if (instance >= this->instances.size())
+		return false;
+	auto& inst = *this->instances[instance];
+	this->space.wait(guard, [&]{return this->terminate || this->failed || inst.events.size() < this->queueCapacity;});
+	if (this->terminate || this->failed)
+		return false;
+	inst.events.push_back(std::move(ev));
+	if (!inst.scheduled)
+	{
+		inst.scheduled = true;
+		this->ready.push_back(instance);
+		guard.unlock();
+		this->work.notify_one();
+	}
+	return true;
+}
+
+bool Alignment::ActiveExecutor::drain()
+{
+	std::unique_lock<std::mutex> guard(this->mutex);
+	this->space.wait(guard, [&]{
+		if (this->failed)
+			return true;
+		for (auto& inst : this->instances)
+			if (inst->scheduled)
+				return false;
+		return true;
+	});
+	return !this->failed;
+}
+
+bool Alignment::ActiveExecutor::stop()
+{
+	this->drain();
+	{
+		std::lock_guard<std::mutex> guard(this->mutex);
+		this->terminate = true;
+	}
+	this->work.notify_all();
+	this->space.notify_all();
+	for (auto& t : this->threads)
+		t.join();
+	this->threads.clear();
+	return !this->failed;
+}
+
+// each thread either updates a batch of events of the next ready instance
+// or, if none is ready, induces the largest eligible slice over all of the instances
+void Alignment::ActiveExecutor::run()
+{
+	std::unique_lock<std::mutex> guard(this->mutex);
+	while (!this->terminate && !this->failed)
+	{
+		if (this->ready.size())
+		{
+			auto instance = this->ready.front();
+			this->ready.pop_front();
+			auto& inst = *this->instances[instance];
+			std::vector<ActiveHierarchyEventPtr> events;
+			for (std::size_t i = 0; i < this->batch && inst.events.size(); i++)
+			{
+				events.push_back(std::move(inst.events.front()));
+				inst.events.pop_front();
+			}
+			this->running++;
+			guard.unlock();
+			this->space.notify_all();
+			auto& active = *inst.active;
+			bool ok = true;
+			for (auto& ev : events)
+			{
+				active.underlyingEventsRepa = ev->eventsRepa;
+				active.underlyingEventsSparse = ev->eventsSparse;
+				ok = ok && active.update(inst.updateParameters);
+				if (!ok)
+					break;
+			}
+			guard.lock();
+			this->running--;
+			inst.updates++;
+			if (!ok)
+				this->failed = true;
+			else if (inst.events.size())
+				this->ready.push_back(instance);
+			else
+				inst.scheduled = false;
+			this->space.notify_all();
+			continue;
+		}
+		if (this->inducing < this->induceThreadMax)
+		{
+			// scan the instances outside of the executor lock
+			std::vector<std::pair<std::size_t,std::size_t>> scans;
+			std::vector<ActiveExecutorInstance*> scansInstance;
+			for (std::size_t i = 0; i < this->instances.size(); i++)
+			{
+				auto& inst = *this->instances[i];
+				if (inst.induceIs && inst.updates != inst.updatesScanned 
+					&& inst.inducing < std::max((std::size_t)1, inst.induceParameters.asyncThreadMax))
+				{
+					scans.push_back(std::make_pair(i, inst.updates));
+					scansInstance.push_back(&inst);
+				}
+			}
+			std::size_t instanceA = 0;
+			std::size_t sliceA = 0;
+			std::size_t sliceSizeA = 0;	
+			if (scans.size())
+			{
+				guard.unlock();
+				SizeList unfound;
+				for (std::size_t k = 0; k < scans.size(); k++)
+				{
+					auto& p = scans[k];
+					auto& inst = *scansInstance[k];
+					auto& active = *inst.active;
+					auto& pp = inst.induceParameters;
+					bool found = false;
+					ActiveLockGuard guard1(active.mutex, active.lockStats, "executor scheduler", true, true);		
+					for (auto sliceB : active.induceSlices)
+					{
+						if (active.inducingSlices.count(sliceB))
+							continue;
+						auto it = active.historySlicesSetEvent.find(sliceB);
+						auto sliceSizeB = it != active.historySlicesSetEvent.end() ? it->second.size() : 0;
+						auto it1 = active.induceSliceFailsSize.find(sliceB);
+						if (sliceSizeB && (it1 == active.induceSliceFailsSize.end() 
+							|| (it1->second < sliceSizeB && pp.induceThresholdExceeded(it1->second, sliceSizeB))))
+						{
+							found = true;
+							if (sliceSizeB > sliceSizeA)
+							{
+								instanceA = p.first;
+								sliceA = sliceB;
+								sliceSizeA = sliceSizeB;
+							}
+						}
+					}
+					if (!found)
+						unfound.push_back(p.first);
+				}
+				guard.lock();
+				// an instance without an eligible slice is not scanned again until it is updated
+				for (auto& p : scans)
+					for (auto i : unfound)
+						if (i == p.first && this->instances[i]->updates == p.second)
+							this->instances[i]->updatesScanned = p.second;
+			}
+			if (sliceSizeA && this->inducing < this->induceThreadMax
+				&& this->instances[instanceA]->inducing < std::max((std::size_t)1, this->instances[instanceA]->induceParameters.asyncThreadMax))
+			{
+				auto& inst = *this->instances[instanceA];
+				auto& active = *inst.active;
+				bool claimed = false;
+				{
+					ActiveLockGuard guard1(active.mutex, active.lockStats, "executor scheduler");		
+					claimed = active.inducingSlices.insert(sliceA).second;
+				}
+				if (claimed)
+				{
+					auto pp = inst.induceParameters;
+					pp.asyncThreadMax = 1;
+					inst.inducing++;
+					this->inducing++;
+					guard.unlock();
+					bool ok = active.induce(sliceA, pp, inst.updateParameters);
+					{
+						ActiveLockGuard guard1(active.mutex, active.lockStats, "executor scheduler");		
+						active.inducingSlices.erase(sliceA);
+					}
+					guard.lock();
+					inst.inducing--;
+					this->inducing--;
+					inst.updates++;
+					if (!ok)
+						this->failed = true;
+					this->space.notify_all();
+				}
+				continue;
+			}
+		}
+		if (this->induceInterval)
+			this->work.wait_for(guard, std::chrono::milliseconds(this->induceInterval));
+		else
+			this->work.wait(guard);
+	}
+	this->space.notify_all();
+}
+
+ActiveSharded::ActiveSharded() : router("router"), shardNext(0)
+{
+}
+
+bool Alignment::ActiveSharded::start(const DecompFudSlicedRepa& rootA, const ActiveSliceIndicator* rootIndicatorA)
+{
+	bool ok = true;
+	ok = ok && this->shards.size() && rootA.fuds.size() && rootA.fuds.front().parent == 0;
+	for (auto active : this->shards)
+	{
+		ok = ok && active && active->system && active->system == this->shards.front()->system;
+		ok = ok && active->frameHistorys.size() == 0;
+		ok = ok && (active->frameUnderlyings.size() == 0 
+			|| (active->frameUnderlyings.size() == 1 && active->frameUnderlyings.front() == 0));
+		ok = ok && !active->underlyingOffsetIs;
+		ok = ok && active->historySlicesSetEvent.size() <= 1;
+		ok = ok && active->underlyingHistoryRepa.size() == this->shards.front()->underlyingHistoryRepa.size();
+		ok = ok && active->underlyingHistorySparse.size() == this->shards.front()->underlyingHistorySparse.size();
+		if (!ok)
+			break;
+	}
+	if (!ok)
+		return ok;
+	auto& root = rootA.fuds.front();
+	auto decompRoot = [&root]()
+	{
+		auto dr = std::make_unique<DecompFudSlicedRepa>();
+		dr->fuds.push_back(root);
+		dr->fudRepasSize = root.fud.size();
+		dr->mapVarInt();
+		dr->mapVarParent();
+		return dr;
+	};
+	for (auto active : this->shards)
+	{
+		ActiveLockGuard guard(active->mutex, active->lockStats, "sharded start");
+		active->decomp = decompRoot();
+		active->decompGeneration++;
+		active->sliceIndicators.clear();
+		if (rootIndicatorA)
+			active->sliceIndicators[0] = *rootIndicatorA;
+	}
+	this->shardsTickets.clear();
+	for (std::size_t i = 0; i < this->shards.size(); i++)
+		this->shardsTickets.push_back(std::make_unique<ActiveShardTickets>());
+	auto& active0 = *this->shards.front();
+	auto& router = this->router;
+	ActiveLockGuard guard(router.mutex, router.lockStats, "sharded start");
+	router.system = active0.system;
+	router.bits = active0.bits;
+	router.var = active0.var;
+	router.varSlice = active0.varSlice;
+	router.historySize = 1;
+	router.historyOverflow = false;
+	router.historyEvent = 0;
+	router.induceThreshold = std::numeric_limits<std::size_t>::max();
+	router.induceVarComputeds = active0.induceVarComputeds;
+	router.frameUnderlyings = active0.frameUnderlyings;
+	router.decomp = decompRoot();
+	router.sliceIndicators.clear();
+	if (rootIndicatorA)
+		router.sliceIndicators[0] = *rootIndicatorA;
+	router.underlyingHistoryRepa.clear();
+	for (auto& hr0 : active0.underlyingHistoryRepa)
+	{
+		auto n = hr0->dimension;
+		auto hr = std::make_shared<HistoryRepa>();
+		hr->dimension = n;
+		hr->vectorVar = new std::size_t[n];
+		hr->shape = new std::size_t[n];
+		for (std::size_t i = 0; i < n; i++)
+		{
+			hr->vectorVar[i] = hr0->vectorVar[i];
+			hr->shape[i] = hr0->shape[i];
+		}
+		hr->size = 1;
+		hr->evient = true;
+		hr->arr = new unsigned char[n];
+		std::memset(hr->arr, 0, n);
+		router.underlyingHistoryRepa.push_back(hr);
+	}
+	router.underlyingHistorySparse.clear();
+	for (std::size_t h = 0; h < active0.underlyingHistorySparse.size(); h++)
+	{
+		auto hr = std::make_shared<HistorySparseArray>(1,1);
+		hr->arr[0] = 0;
+		router.underlyingHistorySparse.push_back(hr);
+	}
+	router.underlyingSlicesParent = active0.underlyingSlicesParent;
+	return ok;
+}
+
+// only the top-level slice is evaluated under the sharded mutex, which is released before the shard's update
+// a ticket taken under the mutex keeps the events of each shard in routing order
+bool Alignment::ActiveSharded::update(std::vector<ActiveEventRepaPtr> eventsRepa, std::vector<ActiveEventSparsePtr> eventsSparse, std::size_t& shardA, ActiveUpdateParameters pp)
+{
+	bool ok = true;
+	std::size_t ticket = 0;
+	{
+		std::lock_guard<std::mutex> guard(this->mutex);
+		auto& router = this->router;
+		ok = ok && this->shards.size() && this->shardsTickets.size() == this->shards.size();
+		ok = ok && eventsRepa.size() == router.underlyingHistoryRepa.size();
+		ok = ok && eventsSparse.size() == router.underlyingHistorySparse.size();
+		for (auto& ev : eventsRepa)
+			ok = ok && ev && ev->state && ev->state->size == 1;
+		for (auto& ev : eventsSparse)
+			ok = ok && (!ev || !ev->state || ev->state->size == 1);
+		std::size_t sliceA = 0;
+		if (ok)
+		{
+			auto& hrs = this->routeRepa;
+			auto& has = this->routeSparse;
+			hrs.clear();
+			for (auto& ev : eventsRepa)
+				hrs.push_back(ev->state);
+			has.clear();
+			for (auto& ev : eventsSparse)
+				has.push_back(ev ? ev->state : HistorySparseArrayPtr());
+			// keep the sparse ancestors of the event, as update does, for later events that have only their leaves
+			auto& slpp = router.underlyingSlicesParent;
+			for (auto& hr1 : has)
+				if (hr1)
+				{
+					auto rr1 = hr1->arr;
+					for (int i = (int)hr1->capacity-1; i > 0; i--)
+						if (rr1[i])
+						{
+							if (slpp.find(rr1[i]) == slpp.end())
+								for (; i > 0; i--)
+									if (rr1[i] && rr1[i-1])
+										slpp[rr1[i]] = rr1[i-1];
+							break;
+						}
+				}
+			auto& jj = this->routeVarValues;
+			jj.clear();
+			router.classifyListVarValues(hrs, has, 0, true, 0, jj);
+			router.eventPathSlice(jj, pp.mapCapacity, this->routeVarValueMap, this->routePath);
+			if (this->routePath.size())
+				sliceA = this->routePath.front();
+			hrs.clear();
+			has.clear();
+		}
+		if (ok)
+		{
+			auto it = this->slicesShard.find(sliceA);
+			if (it == this->slicesShard.end())
+			{
+				shardA = this->shardNext;
+				this->shardNext = (this->shardNext + 1) % this->shards.size();
+				this->slicesShard.insert_or_assign(sliceA, shardA);
+			}
+			else
+				shardA = it->second;
+			ticket = this->shardsTickets[shardA]->next++;
+		}
+	}
+	if (ok)
+	{
+		auto& tickets = *this->shardsTickets[shardA];
+		std::unique_lock<std::mutex> guardShard(tickets.mutex);
+		tickets.turn.wait(guardShard, [&tickets, ticket]{return tickets.serving == ticket;});
+		auto& active = *this->shards[shardA];
+		active.underlyingEventsRepa = std::move(eventsRepa);
+		active.underlyingEventsSparse = std::move(eventsSparse);
+		ok = ok && active.update(pp);
+		// the turn passes on even if the update failed, so that the later updates of the shard do not wait forever
+		tickets.serving++;
+		guardShard.unlock();
+		tickets.turn.notify_all();
+	}
+	return ok;
+}
@@ -7,9 +7,239 @@
 
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <atomic>
+#include <shared_mutex>
+#include <random>
+#include <chrono>
+#include <cstring>
 
 namespace Alignment
 {
+	// lock wait and hold times by call site, recorded only if compiled with ALIGNMENTACTIVE_LOCK_STATS
+	struct ActiveLockStats
+	{
+		static const std::size_t bucketsSize = 256;
+		struct Site
+		{
+			std::size_t count = 0;
+			std::size_t waitTotal = 0;
+			std::size_t waitMax = 0;
+			std::size_t holdTotal = 0;
+			std::size_t holdMax = 0;
+			std::size_t waitBuckets[bucketsSize] = {};
+			std::size_t holdBuckets[bucketsSize] = {};
+		};
+		struct SiteLess
+		{
+			inline bool operator()(const char* a, const char* b) const
+			{
+				return std::strcmp(a, b) < 0;
+			}
+		};
+		std::mutex mutex;
+		std::map<const char*, Site, SiteLess> sites;
+		void record(const char* site, std::size_t waitNanos, std::size_t holdNanos);
+		void reset();
+		// sites ordered by total wait, times in nanoseconds
+		std::string report(std::size_t top = 10);
+	};
+
+	// shared mutex that blocks new readers while a writer is waiting, so that update is not starved by readers
+	struct ActiveSharedMutex
+	{
+		std::mutex mutex;
+		std::condition_variable readersCondition;
+		std::condition_variable writersCondition;
+		std::size_t readers = 0;
+		std::size_t writersWaiting = 0;
+		bool writer = false;
+		void lock();
+		void unlock();
+		void lock_shared();
+		void unlock_shared();
+	};
+
+	// exclusive lock of the active mutex, or shared if sharedIs, for read only sites
+	struct ActiveLockGuard
+	{
+#ifdef ALIGNMENTACTIVE_LOCK_STATS
+		inline ActiveLockGuard(ActiveSharedMutex& mutexA, ActiveLockStats& statsA, const char* siteA, bool lockIsA = true, bool sharedIsA = false) : mutex(mutexA), lockIs(lockIsA), sharedIs(sharedIsA), stats(statsA), site(siteA)
+		{
+			if (!this->lockIs)
+				return;
+			auto mark = std::chrono::steady_clock::now();
+			if (this->sharedIs)
+				this->mutex.lock_shared();
+			else
+				this->mutex.lock();
+			this->locked = std::chrono::steady_clock::now();
+			this->wait = (std::size_t)std::chrono::duration_cast<std::chrono::nanoseconds>(this->locked - mark).count();
+		}
+		inline ~ActiveLockGuard()
+		{
+			if (!this->lockIs)
+				return;
+			auto hold = (std::size_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->locked).count();
+			if (this->sharedIs)
+				this->mutex.unlock_shared();
+			else
+				this->mutex.unlock();
+			this->stats.record(this->site, this->wait, hold);
+		}
+		ActiveSharedMutex& mutex;
+		bool lockIs;
+		bool sharedIs;
+		ActiveLockStats& stats;
+		const char* site;
+		std::chrono::steady_clock::time_point locked;
+		std::size_t wait;
+#else
+		inline ActiveLockGuard(ActiveSharedMutex& mutexA, ActiveLockStats&, const char*, bool lockIsA = true, bool sharedIsA = false) : mutex(mutexA), lockIs(lockIsA), sharedIs(sharedIsA)
+		{
+			if (this->lockIs && this->sharedIs)
+				this->mutex.lock_shared();
+			else if (this->lockIs)
+				this->mutex.lock();
+		}
+		inline ~ActiveLockGuard()
+		{
+			if (this->lockIs && this->sharedIs)
+				this->mutex.unlock_shared();
+			else if (this->lockIs)
+				this->mutex.unlock();
+		}
+		ActiveSharedMutex& mutex;
+		bool lockIs;
+		bool sharedIs;
+#endif
+		ActiveLockGuard(const ActiveLockGuard&) = delete;
+		ActiveLockGuard& operator=(const ActiveLockGuard&) = delete;
+	};
+
+	// open addressing map of variables to values which is cleared in constant time and does not allocate once grown
+	struct ActiveVarValueMap
+	{
+		std::vector<std::size_t> keys;
+		std::vector<unsigned char> values;
+		std::vector<std::size_t> stamps;
+		std::size_t stamp = 0;
+		std::size_t count = 0;
+		int shift = 64;
+		inline std::size_t index(std::size_t key) const
+		{
+			return (std::size_t)((key * 0x9E3779B97F4A7C15ull) >> this->shift);
+		}
+		// clears and grows to hold at least the given number of entries at half load
+		void clear(std::size_t capacity);
+		inline void assign(std::size_t key, unsigned char value)
+		{
+			if (2 * (this->count + 1) > this->keys.size())
+				this->grow();
+			auto mask = this->keys.size() - 1;
+			for (auto i = this->index(key); ; i = (i + 1) & mask)
+			{
+				if (this->stamps[i] != this->stamp)
+				{
+					this->stamps[i] = this->stamp;
+					this->keys[i] = key;
+					this->values[i] = value;
+					this->count++;
+					return;
+				}
+				if (this->keys[i] == key)
+				{
+					this->values[i] = value;
+					return;
+				}
+			}
+		}
+		// the value of the key or 0 if absent
+		inline unsigned char at(std::size_t key) const
+		{
+			if (!this->count)
+				return 0;
+			auto mask = this->keys.size() - 1;
+			for (auto i = this->index(key); this->stamps[i] == this->stamp; i = (i + 1) & mask)
+				if (this->keys[i] == key)
+					return this->values[i];
+			return 0;
+		}
+		void grow();
+	};
+
+	// the slices of a fud in compact form instead of one-hot transforms
+	// the child of the state index of the slice variables, row-major with the first variable most significant, otherwise the remainder
+	struct ActiveSliceIndicator
+	{
+		SizeList vars;
+		SizeList shape;
+		SizeSizeUMap indexChild;
+		std::size_t remainder = 0;
+	};
+	
+	// the successors of each slice ordered by transition count, maintained under the active mutex as the transition cache changes
+	// queries take only a shared lock of the index so that polling consumers do not contend with update
+	struct ActiveTransitionIndex
+	{
+		struct Successors
+		{
+			std::size_t total = 0;
+			SizeSizeUMap counts;
+			std::set<std::pair<std::size_t,std::size_t>, std::greater<std::pair<std::size_t,std::size_t>>> countsOrdered;
+		};
+		mutable std::shared_mutex mutex;
+		std::unordered_map<std::size_t, Successors> slicesSuccessors;
+		// add or remove one transition from sliceA to sliceB
+		void increment(std::size_t sliceA, std::size_t sliceB);
+		void decrement(std::size_t sliceA, std::size_t sliceB);
+		// replace the successors of one slice
+		void assign(std::size_t sliceA, const SizeSizeMap& successors);
+		// replace the index with the given transition cache
+		void build(const std::unordered_map<std::size_t, SizeSizeMap>& nexts);
+		// the k most likely next slices with their probabilities, in decreasing order
+		DoubleSizePairList topNext(std::size_t sliceA, std::size_t k) const;
+		double probability(std::size_t sliceA, std::size_t sliceB) const;
+	};
+	
+	// the counts of the values of the current frame underlying variables of the events of a slice
+	// repa variables by value, and sparse and computed variables with their ancestors by presence
+	struct ActiveSliceCounts
+	{
+		std::size_t size = 0;
+		std::unordered_map<std::size_t, SizeList> repa;
+		SizeSizeUMap sparse;
+	};
+	
+	struct Active;
+
+	// bounded lock-free multi-producer queue of log records drained by one background thread into Active::log
+	// may be shared by several actives, each of which must outlive its records
+	struct ActiveLogQueue
+	{
+		ActiveLogQueue(std::size_t capacityA = 4096);
+		~ActiveLogQueue();
+		struct Record
+		{
+			std::atomic<std::size_t> sequence;
+			Active* active;
+			std::string text;
+		};
+		std::size_t capacity;
+		std::unique_ptr<Record[]> records;
+		std::atomic<std::size_t> enqueuePos;
+		std::atomic<std::size_t> dequeuePos;
+		std::atomic<bool> terminate;
+		std::thread thread;
+		// blocks while the queue is full
+		void push(Active& active, const std::string& str);
+		// waits until all records pushed so far have been passed to the sink
+		void flush();
+		void run();
+	};
+	
 	struct ActiveSystem
 	{
 		ActiveSystem();
@@ -37,6 +267,14 @@ namespace Alignment
 	};
 	
 	typedef std::shared_ptr<ActiveEventSparse> ActiveEventSparsePtr;
+	
+	// pool of sparse event states by capacity, a state is reused once no consumer holds it
+	struct ActiveEventSparsePool
+	{
+		std::size_t sizeMax = 16;
+		std::unordered_map<std::size_t, HistorySparseArrayPtrList> states;
+		HistorySparseArrayPtr get(std::size_t capacity);
+	};
 		
 	struct ActiveUpdateParameters
 	{
@@ -79,6 +317,27 @@ namespace Alignment
 		std::size_t asyncInterval = 10;
 		std::size_t asyncUpdateLimit = 0;
 		bool logging = false;
+		// an induction that exceeds timeMax seconds, if non-zero, or whose cancel is set, is abandoned and recorded as failed
+		// checked between the phases, a layerer that is running is only stopped if forkIs
+		double timeMax = 0.0;
+		std::shared_ptr<std::atomic<bool>> cancel;
+		// if non-zero the commit moves the events of the slice to the children in steps of at most commitTimeMax seconds
+		// under the lock, the rebuild of the cached transitions of the children in the last step is not bounded
+		double commitTimeMax = 0.0;
+		// on linux if forkIs the copy and the model are done in a forked child, so that a crash in the layerer fails the 
+		// induction rather than the process, the child is killed if it overruns timeMax, which is required
+		bool forkIs = false;
+	};
+	
+	struct ActivePruneParameters
+	{
+		// the number of event ids for which the subtree of a slice must have been empty before its fuds are removed
+		std::size_t emptyEvents = 100000;
+		// the maximum number of fuds examined, and of the slices of their subtrees walked, per lock of the active
+		std::size_t scanMax = 1000;
+		// if set prune runs until terminate, sleeping for interval milliseconds between scans
+		std::size_t interval = 0;
+		bool logging = false;
 	};
 	
 	struct ActiveIOParameters
@@ -86,22 +345,102 @@ namespace Alignment
 		std::string filename;
 	};
 	
+	// recording of the underlying events of each update and of the inductions, see Active::recordStart
+	struct ActiveRecordHeader
+	{
+		std::string name;
+		std::size_t historySize = 0;
+		int bits = 16;
+		std::size_t induceThreshold = 0;
+		std::size_t underlyingEventUpdated = 0;
+		SizeList frameUnderlyings;
+		SizeList frameHistorys;
+		bool underlyingOffsetIs = false;
+		SizeList induceVarComputeds;
+		SizeList induceVarExclusions;
+		// variables and shapes of the underlying repa, with size 1
+		HistoryRepaPtrList underlyingRepa;
+		std::size_t underlyingSparseSize = 0;
+	};
+	
+	struct ActiveRecord
+	{
+		// 'U' update, 'I' induce commit or fail
+		char type = 0;
+		// nanoseconds since the recording started
+		std::size_t time = 0;
+		std::vector<ActiveEventRepaPtr> eventsRepa;
+		std::vector<ActiveEventSparsePtr> eventsSparse;
+		// updates recorded before the induce commit or fail
+		std::size_t updates = 0;
+		std::size_t slice = 0;
+		std::size_t sliceSize = 0;
+		bool fail = false;
+		double duration = 0.0;
+		ActiveInduceParameters induceParameters;
+	};
+	
+	struct ActiveRecorder
+	{
+		std::ofstream out;
+		std::chrono::steady_clock::time_point start;
+		std::size_t updates = 0;
+	};
+	
+	struct ActiveRecordReader
+	{
+		std::ifstream in;
+		ActiveRecordHeader header;
+		// set when next fails on a truncated or corrupt record rather than at the end of the recording
+		bool bad = false;
+		bool open(const std::string& filename);
+		// reuses the event states of the record where the variables are unchanged
+		bool next(ActiveRecord& record);
+	};
+	
+	// bump allocator of blocks for the transforms of a decomp and their arrays, which are never freed individually
+	// each arena transform holds a reference to its arena, so the arena lives until the last of its transforms is released
+	struct ActiveArena
+	{
+		ActiveArena(std::size_t blockSizeA = 1 << 20);
+		std::size_t blockSize;
+		std::vector<std::unique_ptr<char[]>> blocks;
+		std::size_t blockUsed;
+		std::size_t blockCapacity;
+		std::size_t allocated;
+		void* allocate(std::size_t size);
+	};
+	
+	typedef std::shared_ptr<ActiveArena> ActiveArenaPtr;
+	
+	// a transform of the given dimension and volume with its object and arrays in the arena, the arrays are not initialised
+	TransformRepaPtr activeArenaTransformRepa(const ActiveArenaPtr& arena, std::size_t dimension, std::size_t volume);
+	TransformRepaPtr activeArenaTransformRepa(const ActiveArenaPtr& arena, const TransformRepa& tr);
+	std::size_t activeArenaTransformRepaSize(std::size_t dimension, std::size_t volume);
+	
 	struct Active
 	{
 		Active(std::string nameA = "");
+		~Active();
 		
 		std::string name;
 		
 		volatile bool terminate;
 		void (*log)(Active& active, const std::string&);
 		void (*layerer_log)(const std::string&);
+		// if set log records are formatted by the caller and passed to log by the queue thread
+		std::shared_ptr<ActiveLogQueue> logQueue;
+		void logPost(const std::string&);
 		bool logging;
 		bool summary;
 		
 		void* client;
 		
-		std::mutex mutex;
-		
+		// readers that do not change the active, such as dump, classify and the schedulers' scans, lock it shared
+		// shared readers rely on the decomp's mapVarInt and mapVarParent having been computed while exclusive
+		ActiveSharedMutex mutex;
+		ActiveLockStats lockStats;
+
 		std::vector<ActiveEventRepaPtr> underlyingEventsRepa;
 		std::vector<ActiveEventSparsePtr> underlyingEventsSparse;
 		std::size_t underlyingEventUpdated;
@@ -118,6 +457,16 @@ namespace Alignment
 		SizeSizeUMap underlyingSlicesParent;
 
 		std::shared_ptr<DecompFudSlicedRepa> decomp;
+		// if sliceIndicatorIs new fuds have compact slices, which are not in the decomp's fuds but in sliceIndicators by parent slice
+		// a decomp with compact slices can only be evaluated by Active::eventPathSlice
+		bool sliceIndicatorIs;
+		std::unordered_map<std::size_t, ActiveSliceIndicator> sliceIndicators;
+		// incremented whenever the fuds of the decomp are changed by the active
+		std::size_t decompGeneration;
+		// if set the transforms of the decomp are allocated from the arena, which is compacted on load and on dump if mostly unused
+		ActiveArenaPtr arena;
+		// copies the transforms of the decomp to a new arena, to be called with the mutex locked
+		void arenaCompact(bool force = true);
 		
 		std::unique_ptr<HistorySparseArray> historySparse;
 		SizeSizeSetMap historySlicesSetEvent;
@@ -128,8 +477,27 @@ namespace Alignment
 		SizeSizeUMap historySlicesLength;
 		std::unordered_map<std::size_t, SizeSizeMap> historySlicesSlicesSizeNext;
 		std::unordered_map<std::size_t, SizeSet> historySlicesSliceSetPrev;
+		// if transitionIndexIs the transition cache is also indexed for queries in transitionIndex
+		bool transitionIndexIs;
+		ActiveTransitionIndex transitionIndex;
+		// recompute the non-cumulative sizes and transitions, to be called with the mutex locked
+		void historySlicesCache();
+		// rebuild historySlicesSetEvent, the slices to induce and the caches from historySparse, to be called with the mutex locked
+		void historySlicesRebuild();
+		// change the historySize in place, keeping the most recent events that fit
+		bool resize(std::size_t historySizeA);
+		// incremented whenever the events of the ring are remapped, so that the commit of an induction in flight fails
+		std::size_t historyGeneration;
+		// re-evaluate the slices of all of the events of the history against the current decomp
+		bool reslice(std::size_t threadsSize = 0, std::size_t mapCapacity = 3);
 			
 		ActiveEventSparsePtr eventSparse;
+		ActiveEventSparsePool eventSparsePool;
+		// if lazy the state of eventSparse is only created when read by eventSparseRead, otherwise it is set by update
+		bool eventSparseLazyIs;
+		bool eventSparseStale;
+		SizeList eventSparsePath;
+		ActiveEventSparse eventSparseRead();
 		
 		std::shared_ptr<ActiveSystem> system;
 		
@@ -139,6 +507,28 @@ namespace Alignment
 		
 		std::size_t induceThreshold;
 		SizeSet induceSlices;
+		// if induceSampleSize is non-zero each slice keeps a uniform sample of at most induceSampleSize of its events by reservoir sampling
+		// and induce models the sample rather than all of the slice, the rest of the slice is resliced on commit
+		std::size_t induceSampleSize;
+		std::unordered_map<std::size_t, SizeList> historySlicesSample;
+		// the position plus one of each history event in the sample of its slice, or zero if not sampled
+		SizeList historySampleIndex;
+		std::ranlux48_base sampleGenerator;
+		// maintain the samples as an event joins or leaves a slice, to be called with the mutex locked after historySlicesSetEvent is changed
+		void sampleInsert(std::size_t sliceA, std::size_t historyEventA);
+		void sampleRemove(std::size_t sliceA, std::size_t historyEventA);
+		void sampleSlice(std::size_t sliceA);
+		void samplesRebuild();
+		// if induceCountsIs update maintains the counts of the variables of each slice of at least half the induce threshold, so
+		// that induce can rank the variables by entropy without a pass over the slice, only if there are no frames other than the current frame
+		bool induceCountsIs;
+		std::unordered_map<std::size_t, ActiveSliceCounts> historySlicesCounts;
+		// add or remove the values of an event in the history to the counts of a slice, to be called with the mutex locked
+		// before the event is overwritten
+		void sliceCountsEvent(std::size_t sliceA, std::size_t historyEventA, bool add);
+		bool sliceCountsNear(std::size_t sliceA) const;
+		void sliceCounts(std::size_t sliceA);
+		void slicesCountsRebuild();
 		SizeSet induceVarExclusions;
 		SizeSet induceVarComputeds;
 		SizeSizeMap induceSliceFailsSize;
@@ -160,22 +550,211 @@ namespace Alignment
 		std::map<std::size_t, SizeSizeUMap> underlyingsVarsOffset;	
 
 		void varPromote(SizeSizeUMap&, std::size_t&);		
+		// promotes the variable if it already has a promotion in the map, otherwise returns false
+		bool varPromoteFind(const SizeSizeUMap&, std::size_t&) const;
 		std::size_t varDemote(const SizeSizeUMap&, std::size_t) const;		
 		
 		std::size_t varMax() const;
 		std::size_t varComputedMax() const;
+
+		// kernels of update and induce, to be called with the mutex locked
+		void eventListVarValues(std::size_t historyEventA, bool dynamicIs, SizeUCharStructList& jj);
+		std::unique_ptr<HistoryRepa> varientHistoryRepa(const SizeList& eventsA, SizeSet& qqr);
+		void sparseCountsDescendants(const HistorySparseArray& haa, const SizeSizeUMap& slppa, SizeSizeUMap& qqa, std::unordered_map<std::size_t, SizeSet>& mma) const;
+		void sliceTransforms(std::size_t sliceA, const SizeList& kk, const std::size_t* skk, const double* rr0, std::size_t sz, TransformRepaPtrList& ll, SizeList& sl);
+		// the path of slices of the variable values in the decomp, as listVarValuesDecompFudSlicedRepasPathSlice_u but without allocating
+		void eventPathSlice(const SizeUCharStructList& jj, std::size_t mapCapacity, ActiveVarValueMap& mm, SizeList& ll) const;
+		
+		void classifyListVarValues(const HistoryRepaPtrList& hrs, const HistorySparseArrayPtrList& has, std::size_t k, bool historyIs, std::size_t historyEventA, SizeUCharStructList& jj) const;
 		
+		// scratch of update, reused so that a steady state update does not allocate
+		SizeUCharStructList updateVarValues;
+		ActiveVarValueMap updateVarValueMap;
+		SizeList updatePath;
+		HistoryRepaPtrList updateHistoryRepas;
+		HistorySparseArrayPtrList updateHistorySparses;
+
 		bool update(ActiveUpdateParameters pp = ActiveUpdateParameters());
 		bool (*updateCallback)(Active& active, std::size_t eventA, std::size_t historyEventA, std::size_t sliceA);
 
+		// the path of slices of the given underlying events as if they were the next update, without changing the history or the model
+		bool classify(const std::vector<ActiveEventRepaPtr>& eventsRepa, const std::vector<ActiveEventSparsePtr>& eventsSparse, SizeList& ll, std::size_t mapCapacity = 3);
+		// the leaf slice and optionally the path of each of the events of the given underlying, in parallel over threadsSize threads
+		// the underlying frames are taken from the earlier events of the batch, history frames are not available
+		bool classifyBatch(const HistoryRepaPtrList& hrs, const HistorySparseArrayPtrList& has, SizeList& slices, SizeListList* paths = 0, std::size_t threadsSize = 0, std::size_t mapCapacity = 3);
+
 		bool induce(ActiveInduceParameters pp = ActiveInduceParameters(),
 					ActiveUpdateParameters ppu = ActiveUpdateParameters());
 		bool induce(std::size_t sliceA, ActiveInduceParameters pp = ActiveInduceParameters(),
 					ActiveUpdateParameters ppu = ActiveUpdateParameters());
 		bool (*induceCallback)(Active& active, std::size_t sliceA, std::size_t sliceSizeA);	
+		// the seconds taken by the induction of the slice, from its start to its commit, valid within induceCallback
+		double induceDuration;
 
+		// remove the fuds below slices whose subtree has had no events in the history for a while
+		bool prune(ActivePruneParameters pp = ActivePruneParameters());
+		SizeSizeUMap pruneSlicesEmptyEvent;
+		std::size_t pruneCursor;
+		
 		bool dump(const ActiveIOParameters&);
-		bool load(const ActiveIOParameters&);	
+		bool load(const ActiveIOParameters&);
+		
+		// stream the underlying events of each update and the inductions to a binary file
+		std::unique_ptr<ActiveRecorder> recorder;
+		bool recordStart(const ActiveIOParameters&);
+		bool recordStop();
+		void recordUpdate();
+		void recordInduce(std::size_t sliceA, std::size_t sliceSizeA, bool fail, double duration, const ActiveInduceParameters& pp);	
+	};
+	
+	// the underlying events of one update of a level of a hierarchy
+	struct ActiveHierarchyEvent
+	{
+		std::vector<ActiveEventRepaPtr> eventsRepa;
+		std::vector<ActiveEventSparsePtr> eventsSparse;
+	};
+	
+	typedef std::shared_ptr<ActiveHierarchyEvent> ActiveHierarchyEventPtr;
+	
+	// bounded blocking first-in first-out queue between the levels of a hierarchy
+	struct ActiveHierarchyQueue
+	{
+		ActiveHierarchyQueue(std::size_t capacityA = 1024);
+		std::size_t capacity;
+		std::mutex mutex;
+		std::condition_variable notFull;
+		std::condition_variable notEmpty;
+		std::deque<ActiveHierarchyEventPtr> events;
+		bool closed;
+		// blocks while the queue is full, returns false if closed
+		bool push(ActiveHierarchyEventPtr ev);
+		// blocks while the queue is empty, returns false if closed and empty
+		bool pop(ActiveHierarchyEventPtr& ev);
+		void close();
+	};
+	
+	struct ActiveHierarchyLevel
+	{
+		Active* active = 0;
+		// the index of the underlying sparse event of this level that is set to the eventSparse of the level below
+		// ignored for the lowest level, the other underlying events of the upper levels are left unchanged
+		std::size_t underlyingIndex = 0;
+		ActiveUpdateParameters updateParameters;
+		// if induceIs and asyncThreadMax then the induce scheduler runs on its own thread
+		// otherwise it runs synchronously on the level's thread after every induceInterval updates
+		bool induceIs = false;
+		ActiveInduceParameters induceParameters;
+		std::size_t induceInterval = 1;
+	};
+	
+	// stacked actives, lowest first, each level updating on its own thread so that the levels are pipelined
+	// the eventSparse of each level is passed in order to the level above through a bounded queue
+	struct ActiveHierarchy
+	{
+		ActiveHierarchy(std::size_t queueCapacityA = 1024);
+		~ActiveHierarchy();
+		std::vector<ActiveHierarchyLevel> levels;
+		std::size_t queueCapacity;
+		std::vector<std::unique_ptr<ActiveHierarchyQueue>> queues;
+		std::vector<std::thread> threads;
+		std::vector<std::thread> induceThreads;
+		std::atomic<bool> failed;
+		bool start();
+		// the events must not be modified by the caller after the push, blocks while the lowest level is full
+		bool push(std::vector<ActiveEventRepaPtr> eventsRepa, std::vector<ActiveEventSparsePtr> eventsSparse);
+		// waits for the queued events to pass through all of the levels, then terminates any induce threads
+		bool stop();
+		void run(std::size_t level);
+	};
+	
+	struct ActiveExecutorInstance
+	{
+		Active* active = 0;
+		ActiveUpdateParameters updateParameters;
+		// if induceIs the slices of the instance compete for the induce threads of the executor
+		// the number of concurrent inductions of the instance is limited by asyncThreadMax, or 1 if zero
+		bool induceIs = false;
+		ActiveInduceParameters induceParameters;
+		std::deque<ActiveHierarchyEventPtr> events;
+		bool scheduled = false;
+		std::size_t inducing = 0;
+		// the slices are scanned for induction only if there have been updates or inductions since the last scan without a candidate
+		std::size_t updates = 1;
+		std::size_t updatesScanned = 0;
+	};
+	
+	// runs the updates and inductions of many actives on a fixed pool of threads
+	// the updates of each instance are in order and the instances with pending events are served round robin
+	// idle threads induce the largest eligible slice of any instance, up to induceThreadMax at once
+	// start clamps induceThreadMax to threadMax - 1, so that one thread is always free to update
+	struct ActiveExecutor
+	{
+		ActiveExecutor(std::size_t threadMaxA = 4, std::size_t induceThreadMaxA = 2);
+		~ActiveExecutor();
+		std::size_t threadMax;
+		std::size_t induceThreadMax;
+		// the maximum pending events of an instance and the maximum updates of an instance per turn
+		std::size_t queueCapacity;
+		std::size_t batch;
+		std::size_t induceInterval;
+		std::mutex mutex;
+		std::condition_variable work;
+		std::condition_variable space;
+		std::vector<std::unique_ptr<ActiveExecutorInstance>> instances;
+		std::deque<std::size_t> ready;
+		std::size_t running;
+		std::size_t inducing;
+		bool terminate;
+		std::atomic<bool> failed;
+		std::vector<std::thread> threads;
+		// returns the instance index, the active must outlive the executor
+		std::size_t add(Active& active, ActiveUpdateParameters ppu = ActiveUpdateParameters(), bool induceIs = false, ActiveInduceParameters ppi = ActiveInduceParameters());
+		bool start();
+		// the events must not be modified by the caller after the post, blocks while the instance queue is full
+		bool post(std::size_t instance, std::vector<ActiveEventRepaPtr> eventsRepa, std::vector<ActiveEventSparsePtr> eventsSparse);
+		// waits until all posted events have been updated
+		bool drain();
+		// drains and then waits for the running inductions
+		bool stop();
+		void run();
+	};
+	
+	// the tickets of a shard's updates, taken in routing order and served in turn
+	struct ActiveShardTickets
+	{
+		std::mutex mutex;
+		std::condition_variable turn;
+		// taken under the sharded mutex
+		std::size_t next = 0;
+		// advanced under the tickets mutex
+		std::size_t serving = 0;
+	};
+	
+	// actives partitioned by the top-level slice of a shared root fud, so that the updates and inductions of different subtrees do not contend
+	// the events are routed by classifying them against a router active with a decomp of only the root fud
+	// the shards are owned by the caller and must share one system and have the same underlying, with no history frames and only the current underlying frame
+	// each shard has its own history, slices and induce scheduler, and sees only the events of its own subtrees, with gaps in the event ids
+	struct ActiveSharded
+	{
+		ActiveSharded();
+		// guards the router, its buffers and the slice assignments, but not the shards
+		std::mutex mutex;
+		Active router;
+		std::vector<Active*> shards;
+		std::vector<std::unique_ptr<ActiveShardTickets>> shardsTickets;
+		// the top-level slices that are not assigned to a shard are assigned round robin as they are first seen
+		SizeSizeUMap slicesShard;
+		std::size_t shardNext;
+		HistoryRepaPtrList routeRepa;
+		HistorySparseArrayPtrList routeSparse;
+		SizeUCharStructList routeVarValues;
+		ActiveVarValueMap routeVarValueMap;
+		SizeList routePath;
+		// sets the router and the decomp of each shard to the root fud, which must be the first fud of rootA
+		// if the root fud has compact slices then its indicator must also be given
+		bool start(const DecompFudSlicedRepa& rootA, const ActiveSliceIndicator* rootIndicatorA = 0);
+		// may be called from many threads, the events of each shard are updated in the order in which they were routed
+		bool update(std::vector<ActiveEventRepaPtr> eventsRepa, std::vector<ActiveEventSparsePtr> eventsSparse, std::size_t& shardA, ActiveUpdateParameters pp = ActiveUpdateParameters());
 	};
 }
 
@@ -0,0 +1,348 @@
+#include "AlignmentUtil.h"
+#include "Alignment.h"
+#include "AlignmentRepa.h"
+#include "AlignmentActive.h"
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <sys/resource.h>
+
+using namespace Alignment;
+using namespace std;
+
+typedef std::chrono::duration<double> sec;
+typedef std::chrono::steady_clock clk;
+
+// synthetic workload for the end-to-end benchmark, all arguments are optional key=value pairs
+// e.g. AlignmentActive_bench events=100000 dimension=40 valency=8 sparse=2 frames=2 ring=10000 induce=async
+struct BenchParameters
+{
+	std::size_t events = 20000;
+	std::size_t dimension = 20;
+	std::size_t valency = 4;
+	std::size_t computed = 0;
+	std::size_t sparse = 0;
+	std::size_t sparseDepth = 3;
+	std::size_t sparseBranch = 4;
+	std::size_t frames = 1;
+	std::size_t historyFrames = 0;
+	std::size_t ring = 10000;
+	std::size_t threshold = 200;
+	std::string induce = "sync";
+	std::size_t induceInterval = 1000;
+	std::size_t asyncThreads = 2;
+	std::size_t latents = 4;
+	double noise = 0.2;
+	std::size_t seed = 7;
+	bool logging = false;
+	bool arena = false;
+	bool compact = false;
+};
+
+bool benchParse(int argc, char **argv, BenchParameters& pp)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg(argv[i]);
+		auto k = arg.find('=');
+		if (k == std::string::npos)
+		{
+			cout << "bench\terror: expected key=value: " << arg << endl;
+			return false;
+		}
+		auto key = arg.substr(0,k);
+		auto val = arg.substr(k+1);
+		if (key == "events") pp.events = std::stoull(val);
+		else if (key == "dimension") pp.dimension = std::stoull(val);
+		else if (key == "valency") pp.valency = std::stoull(val);
+		else if (key == "computed") pp.computed = std::stoull(val);
+		else if (key == "sparse") pp.sparse = std::stoull(val);
+		else if (key == "sparseDepth") pp.sparseDepth = std::stoull(val);
+		else if (key == "sparseBranch") pp.sparseBranch = std::stoull(val);
+		else if (key == "frames") pp.frames = std::stoull(val);
+		else if (key == "historyFrames") pp.historyFrames = std::stoull(val);
+		else if (key == "ring") pp.ring = std::stoull(val);
+		else if (key == "threshold") pp.threshold = std::stoull(val);
+		else if (key == "induce") pp.induce = val;
+		else if (key == "induceInterval") pp.induceInterval = std::stoull(val);
+		else if (key == "asyncThreads") pp.asyncThreads = std::stoull(val);
+		else if (key == "latents") pp.latents = std::stoull(val);
+		else if (key == "noise") pp.noise = std::stod(val);
+		else if (key == "seed") pp.seed = std::stoull(val);
+		else if (key == "logging") pp.logging = val == "true" || val == "1";
+		else if (key == "arena") pp.arena = val == "true" || val == "1";
+		else if (key == "compact") pp.compact = val == "true" || val == "1";
+		else
+		{
+			cout << "bench\terror: unknown parameter: " << key << endl;
+			return false;
+		}
+	}
+	bool ok = pp.dimension || pp.sparse;
+	ok = ok && pp.valency >= 2 && pp.valency <= 256;
+	ok = ok && pp.computed <= pp.dimension;
+	ok = ok && pp.ring > pp.frames && pp.ring > pp.historyFrames;
+	ok = ok && pp.frames >= 1 && pp.latents >= 1;
+	ok = ok && (pp.induce == "none" || pp.induce == "sync" || pp.induce == "async");
+	if (!ok)
+		cout << "bench\terror: inconsistent parameters" << endl;
+	return ok;
+}
+
+// generates events from a small number of latent states so that the underlying is aligned
+struct BenchGenerator
+{
+	BenchGenerator(const BenchParameters& ppA) : pp(ppA), gen(ppA.seed) {}
+	const BenchParameters& pp;
+	std::mt19937_64 gen;
+	std::size_t latent = 0;
+	void next()
+	{
+		if (std::uniform_real_distribution<double>(0.0,1.0)(gen) < 0.1)
+			latent = std::uniform_int_distribution<std::size_t>(0,pp.latents-1)(gen);
+	}
+	unsigned char value(std::size_t i)
+	{
+		if (std::uniform_real_distribution<double>(0.0,1.0)(gen) < pp.noise)
+			return (unsigned char)std::uniform_int_distribution<std::size_t>(0,pp.valency-1)(gen);
+		return (unsigned char)((latent * (i+1) + i) % pp.valency);
+	}
+	// sparse paths are ids of a tree of depth sparseDepth and branching sparseBranch
+	void path(std::size_t h, std::size_t* rr)
+	{
+		std::size_t v = (h+1) << 32;
+		for (std::size_t k = 0; k < pp.sparseDepth; k++)
+		{
+			std::size_t b = std::uniform_real_distribution<double>(0.0,1.0)(gen) < pp.noise
+				? std::uniform_int_distribution<std::size_t>(0,pp.sparseBranch-1)(gen)
+				: (latent + k) % pp.sparseBranch;
+			v = v * pp.sparseBranch + b + 1;
+			rr[k] = v;
+		}
+	}
+};
+
+struct BenchState
+{
+	std::vector<double> induceLatencies;
+	std::atomic<std::size_t> inductions;
+};
+
+bool bench_induce_callback(Active& active, std::size_t sliceA, std::size_t sliceSizeA)
+{
+	// the callback is called under the active's lock, so the latencies of concurrent inductions are not interleaved
+	auto& st = *(BenchState*)active.client;
+	st.induceLatencies.push_back(active.induceDuration);
+	st.inductions++;
+	return true;
+}
+
+void bench_log(Active& active, const std::string& str)
+{
+	cout << ">>> " << str << endl;
+}
+
+void run_bench_induce(Active& active, ActiveInduceParameters ppi)
+{
+	active.induce(ppi);
+}
+
+double benchPercentile(const std::vector<double>& ll, double q)
+{
+	if (!ll.size())
+		return 0.0;
+	std::size_t i = (std::size_t)(q * (double)(ll.size()-1));
+	return ll[i];
+}
+
+int main(int argc, char **argv)
+{
+	BenchParameters pp;
+	if (!benchParse(argc, argv, pp))
+		return 1;
+
+	Active active("bench");
+	BenchState st;
+	st.inductions = 0;
+	active.client = &st;
+	active.log = bench_log;
+	active.logging = pp.logging;
+	active.induceCallback = bench_induce_callback;
+	active.system = std::make_shared<ActiveSystem>();
+	active.var = active.system->next(active.bits);
+	active.varSlice = active.system->next(active.bits);
+	active.historySize = pp.ring;
+	active.induceThreshold = pp.threshold;
+	active.decomp = std::make_unique<DecompFudSlicedRepa>();
+	if (pp.arena)
+		active.arena = std::make_shared<ActiveArena>();
+	active.sliceIndicatorIs = pp.compact;
+	active.eventSparse = std::make_shared<ActiveEventSparse>();
+	for (std::size_t f = 0; f < pp.frames; f++)
+		active.frameUnderlyings.push_back(f);
+	for (std::size_t f = 1; f <= pp.historyFrames; f++)
+		active.frameHistorys.push_back(f);
+	auto z = pp.ring;
+	{
+		active.historySparse = std::make_unique<HistorySparseArray>(z,1);
+		std::memset(active.historySparse->arr, 0, z*sizeof(std::size_t));
+	}
+	if (pp.dimension)
+	{
+		auto n = pp.dimension;
+		auto hr = std::make_shared<HistoryRepa>();
+		hr->dimension = n;
+		hr->vectorVar = new std::size_t[n];
+		hr->shape = new std::size_t[n];
+		for (std::size_t i = 0; i < n; i++)
+		{
+			hr->vectorVar[i] = i + 1;
+			hr->shape[i] = pp.valency;
+		}
+		hr->size = z;
+		hr->evient = true;
+		hr->arr = new unsigned char[z*n];
+		std::memset(hr->arr, 0, z*n);
+		active.underlyingHistoryRepa.push_back(hr);
+		auto ev = std::make_shared<ActiveEventRepa>();
+		ev->state = std::make_shared<HistoryRepa>();
+		auto& hr1 = *ev->state;
+		hr1.dimension = n;
+		hr1.vectorVar = new std::size_t[n];
+		hr1.shape = new std::size_t[n];
+		for (std::size_t i = 0; i < n; i++)
+		{
+			hr1.vectorVar[i] = i + 1;
+			hr1.shape[i] = pp.valency;
+		}
+		hr1.size = 1;
+		hr1.evient = true;
+		hr1.arr = new unsigned char[n];
+		active.underlyingEventsRepa.push_back(ev);
+		for (std::size_t i = 0; i < pp.computed; i++)
+			active.induceVarComputeds.insert(i + 1);
+	}
+	for (std::size_t h = 0; h < pp.sparse; h++)
+	{
+		auto hr = std::make_shared<HistorySparseArray>(z,1);
+		std::memset(hr->arr, 0, z*sizeof(std::size_t));
+		active.underlyingHistorySparse.push_back(hr);
+		auto ev = std::make_shared<ActiveEventSparse>();
+		ev->state = std::make_shared<HistorySparseArray>(1,pp.sparseDepth);
+		active.underlyingEventsSparse.push_back(ev);
+	}
+
+	ActiveUpdateParameters ppu;
+	ActiveInduceParameters ppi;
+	ppi.seed = pp.seed;
+	ppi.logging = pp.logging;
+	ppi.induceThresholds = std::set<std::size_t>{pp.threshold*2, pp.threshold*4, pp.threshold*8};
+
+	std::thread induceThread;
+	if (pp.induce == "async")
+	{
+		ppi.asyncThreadMax = pp.asyncThreads;
+		induceThread = std::thread(run_bench_induce, std::ref(active), ppi);
+	}
+
+	BenchGenerator gen(pp);
+	std::vector<double> updateLatencies;
+	updateLatencies.reserve(pp.events);
+	double induceTime = 0.0;
+	double prohibitTime = 0.0;
+	bool ok = true;
+	auto mark = clk::now();
+	for (std::size_t k = 1; ok && k <= pp.events; k++)
+	{
+		gen.next();
+		for (auto& ev : active.underlyingEventsRepa)
+		{
+			ev->id = k;
+			auto& hr1 = *ev->state;
+			for (std::size_t i = 0; i < hr1.dimension; i++)
+				hr1.arr[i] = gen.value(i);
+		}
+		for (std::size_t h = 0; h < active.underlyingEventsSparse.size(); h++)
+		{
+			auto& ev = active.underlyingEventsSparse[h];
+			ev->id = k;
+			gen.path(h, ev->state->arr);
+		}
+		if (pp.induce == "async" && active.updateProhibit)
+		{
+			auto mark1 = clk::now();
+			while (active.updateProhibit && !active.terminate)
+				std::this_thread::sleep_for(std::chrono::microseconds(100));
+			prohibitTime += ((sec)(clk::now() - mark1)).count();
+		}
+		auto mark1 = clk::now();
+		ok = active.update(ppu);
+		updateLatencies.push_back(((sec)(clk::now() - mark1)).count());
+		if (ok && pp.induce == "sync" && pp.induceInterval && k % pp.induceInterval == 0)
+		{
+			auto mark2 = clk::now();
+			ok = active.induce(ppi);
+			induceTime += ((sec)(clk::now() - mark2)).count();
+		}
+	}
+	double totalTime = ((sec)(clk::now() - mark)).count();
+	if (induceThread.joinable())
+	{
+		active.terminate = true;
+		induceThread.join();
+	}
+	if (!ok)
+	{
+		cout << "bench\terror: update or induce failed" << endl;
+		return 1;
+	}
+
+	std::size_t eventsA = updateLatencies.size();
+	double updateTime = 0.0;
+	for (auto t : updateLatencies)
+		updateTime += t;
+	std::sort(updateLatencies.begin(), updateLatencies.end());
+	auto lats = st.induceLatencies;
+	std::sort(lats.begin(), lats.end());
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	cout << std::setprecision(6);
+	cout << "events: " << eventsA << endl;
+	cout << "events per second: " << (double)eventsA / totalTime << endl;
+	cout << "update events per second: " << (double)eventsA / updateTime << endl;
+	cout << "update latency p50: " << benchPercentile(updateLatencies, 0.5) * 1e6 << "us" << endl;
+	cout << "update latency p90: " << benchPercentile(updateLatencies, 0.9) * 1e6 << "us" << endl;
+	cout << "update latency p99: " << benchPercentile(updateLatencies, 0.99) * 1e6 << "us" << endl;
+	cout << "update latency p999: " << benchPercentile(updateLatencies, 0.999) * 1e6 << "us" << endl;
+	cout << "update latency max: " << (eventsA ? updateLatencies.back() : 0.0) * 1e6 << "us" << endl;
+	cout << "update prohibited: " << prohibitTime << "s" << endl;
+	cout << "inductions: " << st.inductions << endl;
+	if (pp.induce == "sync")
+		cout << "induce time: " << induceTime << "s" << endl;
+	if (pp.induce != "none")
+	{
+		// each latency is of one successful induction, from its start to its commit
+		cout << "induce latency p50: " << benchPercentile(lats, 0.5) << "s" << endl;
+		cout << "induce latency p90: " << benchPercentile(lats, 0.9) << "s" << endl;
+		cout << "induce latency max: " << (lats.size() ? lats.back() : 0.0) << "s" << endl;
+	}
+	cout << "fud cardinality: " << active.decomp->fuds.size() << endl;
+	cout << "model cardinality: " << active.decomp->fudRepasSize << endl;
+	if (active.arena)
+		cout << "arena allocated: " << active.arena->allocated << "B" << endl;
+	cout << "slices: " << active.historySlicesSetEvent.size() << endl;
+	cout << "peak memory: " << usage.ru_maxrss << "KB" << endl;
+	cout << "total time: " << totalTime << "s" << endl;
+	cout << active.lockStats.report() << endl;
+
+	return 0;
+}
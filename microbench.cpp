@@ -0,0 +1,354 @@
+#include "AlignmentUtil.h"
+#include "Alignment.h"
+#include "AlignmentRepa.h"
+#include "AlignmentActive.h"
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <functional>
+
+using namespace Alignment;
+using namespace std;
+
+typedef std::chrono::duration<double> sec;
+typedef std::chrono::steady_clock clk;
+
+// micro-benchmarks of the kernels of update and induce, all arguments are optional key=value pairs
+// e.g. AlignmentActive_microbench filter=gather save=micro.txt
+//      AlignmentActive_microbench baseline=micro.txt tolerance=1.1
+struct MicroParameters
+{
+	std::string filter;
+	std::string baseline;
+	std::string save;
+	double tolerance = 1.10;
+	std::size_t repeats = 9;
+	double runTime = 0.02;
+	std::size_t seed = 11;
+};
+
+// results of the kernels are stored here so that their work is not optimised away
+volatile std::size_t microSink = 0;
+
+// median and minimum nanoseconds per call over repeated runs, each long enough to be timed reliably
+std::pair<double,double> microTime(const std::function<void()>& f, const MicroParameters& pp)
+{
+	f();
+	std::size_t iterations = 1;
+	while (true)
+	{
+		auto mark = clk::now();
+		for (std::size_t k = 0; k < iterations; k++)
+			f();
+		double t = ((sec)(clk::now() - mark)).count();
+		if (t >= pp.runTime || iterations >= ((std::size_t)1 << 30))
+			break;
+		iterations = t > 0.0 ? std::max(iterations*2, (std::size_t)(iterations * pp.runTime / t)) : iterations*10;
+	}
+	std::vector<double> ll;
+	ll.reserve(pp.repeats);
+	for (std::size_t r = 0; r < pp.repeats; r++)
+	{
+		auto mark = clk::now();
+		for (std::size_t k = 0; k < iterations; k++)
+			f();
+		ll.push_back(((sec)(clk::now() - mark)).count() * 1e9 / (double)iterations);
+	}
+	std::sort(ll.begin(), ll.end());
+	return std::make_pair(ll[ll.size()/2], ll.front());
+}
+
+struct MicroResult
+{
+	std::string kernel;
+	std::size_t size;
+	double median;
+	double minimum;
+};
+
+// an active with an evient repa underlying of the given dimension and a sparse underlying of the given depth
+// with the ring full of random events
+void microActive(Active& active, std::size_t dimension, std::size_t valency, std::size_t sparse, std::size_t depth, std::size_t frames, std::size_t z, std::size_t seed)
+{
+	std::mt19937_64 gen(seed);
+	active.system = std::make_shared<ActiveSystem>();
+	active.var = active.system->next(active.bits);
+	active.varSlice = active.system->next(active.bits);
+	active.historySize = z;
+	active.historyOverflow = true;
+	active.historyEvent = 0;
+	active.decomp = std::make_unique<DecompFudSlicedRepa>();
+	active.historySparse = std::make_unique<HistorySparseArray>(z,1);
+	std::memset(active.historySparse->arr, 0, z*sizeof(std::size_t));
+	for (std::size_t f = 0; f < frames; f++)
+		active.frameUnderlyings.push_back(f);
+	if (dimension)
+	{
+		auto n = dimension;
+		auto hr = std::make_shared<HistoryRepa>();
+		hr->dimension = n;
+		hr->vectorVar = new std::size_t[n];
+		hr->shape = new std::size_t[n];
+		for (std::size_t i = 0; i < n; i++)
+		{
+			hr->vectorVar[i] = i + 1;
+			hr->shape[i] = valency;
+		}
+		hr->size = z;
+		hr->evient = true;
+		hr->arr = new unsigned char[z*n];
+		for (std::size_t j = 0; j < z*n; j++)
+			hr->arr[j] = (unsigned char)(gen() % valency);
+		active.underlyingHistoryRepa.push_back(hr);
+	}
+	for (std::size_t h = 0; h < sparse; h++)
+	{
+		auto hr = std::make_shared<HistorySparseArray>(z,1);
+		for (std::size_t j = 0; j < z; j++)
+		{
+			std::size_t v = 0;
+			std::size_t x = 0;
+			for (std::size_t k = 0; k < depth; k++)
+			{
+				x = (x * 2 + gen() % 2) & (((std::size_t)1 << 48) - 1);
+				std::size_t w = ((h+1) << 56) + ((k+1) << 48) + x;
+				active.underlyingSlicesParent[w] = v;
+				v = w;
+			}
+			hr->arr[j] = v;
+		}
+		active.underlyingHistorySparse.push_back(hr);
+	}
+	for (std::size_t j = 0; j < z; j++)
+		active.historySlicesSetEvent[0].insert(j);
+}
+
+int main(int argc, char **argv)
+{
+	MicroParameters pp;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg(argv[i]);
+		auto k = arg.find('=');
+		auto key = arg.substr(0,k);
+		auto val = k == std::string::npos ? std::string() : arg.substr(k+1);
+		if (key == "filter") pp.filter = val;
+		else if (key == "baseline") pp.baseline = val;
+		else if (key == "save") pp.save = val;
+		else if (key == "tolerance") pp.tolerance = std::stod(val);
+		else if (key == "repeats") pp.repeats = std::max((std::size_t)1, (std::size_t)std::stoull(val));
+		else if (key == "runTime") pp.runTime = std::stod(val);
+		else if (key == "seed") pp.seed = std::stoull(val);
+		else
+		{
+			cout << "microbench\terror: unknown parameter: " << arg << endl;
+			return 1;
+		}
+	}
+
+	std::vector<MicroResult> results;
+	auto run = [&](const std::string& kernel, std::size_t size, const std::function<void()>& f)
+	{
+		if (pp.filter.size() && kernel.find(pp.filter) == std::string::npos)
+			return;
+		auto t = microTime(f, pp);
+		results.push_back(MicroResult{kernel, size, t.first, t.second});
+		cout << kernel << "\t" << size << "\tmedian: " << std::fixed << std::setprecision(1) << t.first << "ns\tmin: " << t.second << "ns" << std::defaultfloat << endl;
+	};
+
+	// varPromote over maps of increasing numbers of blocks
+	for (std::size_t size : {16, 256, 4096})
+	{
+		Active active;
+		active.system = std::make_shared<ActiveSystem>();
+		SizeSizeUMap mm;
+		SizeList vv;
+		std::size_t block1 = (std::size_t)1 << active.bits;
+		for (std::size_t i = 0; i < size; i++)
+		{
+			std::size_t v = (i+1) * block1 + i;
+			active.varPromote(mm, v);
+			vv.push_back((i+1) * block1 + i);
+		}
+		run("varPromote", size, [&]() {
+			std::size_t x = 0;
+			for (auto v : vv)
+			{
+				active.varPromote(mm, v);
+				x += v;
+			}
+			microSink = x;
+		});
+	}
+
+	// jj assembly in update over repa dimension and three frames
+	for (std::size_t size : {16, 128, 1024})
+	{
+		Active active;
+		microActive(active, size, 4, 1, 4, 3, 1000, pp.seed);
+		SizeUCharStructList jj;
+		std::size_t j = 0;
+		run("update jj", size, [&]() {
+			jj.clear();
+			active.eventListVarValues(j, false, jj);
+			j = (j + 1) % active.historySize;
+		});
+	}
+
+	// sparse ancestor walk over path depth
+	for (std::size_t size : {4, 16, 64})
+	{
+		Active active;
+		microActive(active, 0, 4, 4, size, 1, 1000, pp.seed);
+		SizeUCharStructList jj;
+		std::size_t j = 0;
+		run("sparse ancestors", size, [&]() {
+			jj.clear();
+			active.eventListVarValues(j, false, jj);
+			j = (j + 1) % active.historySize;
+		});
+	}
+
+	// evient to varient gather in the induce copy over slice size
+	for (std::size_t size : {1000, 10000, 100000})
+	{
+		Active active;
+		microActive(active, 32, 4, 0, 0, 2, size, pp.seed);
+		SizeList eventsA;
+		for (std::size_t j = 0; j < size; j++)
+			eventsA.push_back(j);
+		SizeSet qqr0;
+		for (std::size_t i = 0; i < 32; i++)
+			qqr0.insert(i + 1);
+		run("induce gather", size, [&]() {
+			SizeSet qqr(qqr0);
+			auto hrr = active.varientHistoryRepa(eventsA, qqr);
+		});
+	}
+
+	// sparse entropy preparation over slice size
+	for (std::size_t size : {1000, 10000, 100000})
+	{
+		Active active;
+		std::mt19937_64 gen(pp.seed);
+		std::size_t na = 4;
+		std::size_t depth = 8;
+		HistorySparseArray haa(size, na);
+		SizeSizeUMap slppa;
+		for (std::size_t i = 0; i < na; i++)
+			for (std::size_t j = 0; j < size; j++)
+			{
+				std::size_t v = 0;
+				std::size_t x = 0;
+				for (std::size_t k = 0; k < depth; k++)
+				{
+					x = (x * 2 + gen() % 2) & (((std::size_t)1 << 48) - 1);
+					std::size_t w = ((i+1) << 56) + ((k+1) << 48) + x;
+					if (k)
+						slppa[w] = v;
+					v = w;
+				}
+				haa.arr[j*na + i] = v;
+			}
+		run("sparse counts", size, [&]() {
+			SizeSizeUMap qqa;
+			std::unordered_map<std::size_t, SizeSet> mma;
+			active.sparseCountsDescendants(haa, slppa, qqa, mma);
+		});
+	}
+
+	// slice transform creation over the derived volume
+	for (std::size_t size : {16, 256, 4096})
+	{
+		Active active;
+		active.system = std::make_shared<ActiveSystem>();
+		std::mt19937_64 gen(pp.seed);
+		std::size_t m = 0;
+		SizeList skk;
+		for (std::size_t sz = 1; sz < size; sz *= 4)
+		{
+			skk.push_back(4);
+			m++;
+		}
+		SizeList kk;
+		for (std::size_t i = 0; i < m; i++)
+			kk.push_back(active.system->next(active.bits) + i);
+		std::vector<double> rr0(size);
+		for (auto& r : rr0)
+			r = gen() % 3 ? (double)(gen() % 100) : 0.0;
+		run("slice transforms", size, [&]() {
+			active.varSlice = (std::size_t)1 << active.bits;
+			TransformRepaPtrList ll;
+			SizeList sl;
+			ll.reserve(size);
+			sl.reserve(size);
+			active.sliceTransforms(1, kk, skk.data(), rr0.data(), size, ll, sl);
+		});
+	}
+
+	// dump and load round trip over ring size
+	for (std::size_t size : {1000, 10000, 100000})
+	{
+		Active active;
+		microActive(active, 32, 4, 1, 4, 1, size, pp.seed);
+		Active active1;
+		ActiveIOParameters ppio;
+		ppio.filename = "microbench_" + std::to_string(size) + ".bin";
+		bool ok = true;
+		run("dump load", size, [&]() {
+			ok = ok && active.dump(ppio);
+			ok = ok && active1.load(ppio);
+		});
+		std::remove(ppio.filename.c_str());
+		if (!ok)
+		{
+			cout << "microbench\terror: dump load failed: " << ppio.filename << endl;
+			return 1;
+		}
+	}
+
+	bool regression = false;
+	if (pp.baseline.size())
+	{
+		std::ifstream in(pp.baseline);
+		std::map<std::pair<std::string,std::size_t>, double> base;
+		std::string line;
+		while (std::getline(in, line))
+		{
+			std::istringstream ss(line);
+			std::string kernel;
+			std::size_t size;
+			double median;
+			if (std::getline(ss, kernel, '\t') && ss >> size >> median)
+				base[std::make_pair(kernel, size)] = median;
+		}
+		cout << "comparison with baseline: " << pp.baseline << endl;
+		for (auto& r : results)
+		{
+			auto it = base.find(std::make_pair(r.kernel, r.size));
+			if (it == base.end() || it->second <= 0.0)
+				continue;
+			double ratio = r.median / it->second;
+			bool worse = ratio > pp.tolerance;
+			regression = regression || worse;
+			cout << r.kernel << "\t" << r.size << "\tratio: " << std::fixed << std::setprecision(3) << ratio << std::defaultfloat << (worse ? "\tREGRESSION" : "") << endl;
+		}
+	}
+	if (pp.save.size())
+	{
+		std::ofstream out(pp.save);
+		out << std::setprecision(10);
+		for (auto& r : results)
+			out << r.kernel << "\t" << r.size << "\t" << r.median << endl;
+	}
+
+	return regression ? 2 : 0;
+}
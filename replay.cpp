@@ -0,0 +1,299 @@
+#include "AlignmentUtil.h"
+#include "Alignment.h"
+#include "AlignmentRepa.h"
+#include "AlignmentActive.h"
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <sys/resource.h>
+
+using namespace Alignment;
+using namespace std;
+
+typedef std::chrono::duration<double> sec;
+typedef std::chrono::steady_clock clk;
+
+// replay of a recording made by Active::recordStart, all arguments are key=value pairs
+// e.g. AlignmentActive_replay file=active.rec model=active.bin pace=recorded induce=async
+// induce=recorded runs each recorded induction synchronously after the same number of updates as when it completed
+struct ReplayParameters
+{
+	std::string file;
+	std::string model;
+	std::string pace = "fast";
+	std::string induce = "recorded";
+	std::size_t induceInterval = 1000;
+	std::size_t asyncThreads = 2;
+	bool logging = false;
+};
+
+bool replayParse(int argc, char **argv, ReplayParameters& pp)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg(argv[i]);
+		auto k = arg.find('=');
+		if (k == std::string::npos)
+		{
+			cout << "replay\terror: expected key=value: " << arg << endl;
+			return false;
+		}
+		auto key = arg.substr(0,k);
+		auto val = arg.substr(k+1);
+		if (key == "file") pp.file = val;
+		else if (key == "model") pp.model = val;
+		else if (key == "pace") pp.pace = val;
+		else if (key == "induce") pp.induce = val;
+		else if (key == "induceInterval") pp.induceInterval = std::stoull(val);
+		else if (key == "asyncThreads") pp.asyncThreads = std::stoull(val);
+		else if (key == "logging") pp.logging = val == "true" || val == "1";
+		else
+		{
+			cout << "replay\terror: unknown parameter: " << key << endl;
+			return false;
+		}
+	}
+	bool ok = pp.file.size();
+	ok = ok && (pp.pace == "fast" || pp.pace == "recorded");
+	ok = ok && (pp.induce == "recorded" || pp.induce == "none" || pp.induce == "sync" || pp.induce == "async");
+	if (!ok)
+		cout << "replay\terror: inconsistent parameters" << endl;
+	return ok;
+}
+
+// a fresh active with an empty model and the underlying of the recording
+void replayActive(Active& active, const ActiveRecordHeader& hh)
+{
+	active.system = std::make_shared<ActiveSystem>();
+	active.bits = hh.bits;
+	active.var = active.system->next(active.bits);
+	active.varSlice = active.system->next(active.bits);
+	active.historySize = hh.historySize;
+	active.induceThreshold = hh.induceThreshold;
+	active.underlyingEventUpdated = hh.underlyingEventUpdated;
+	active.decomp = std::make_unique<DecompFudSlicedRepa>();
+	active.eventSparse = std::make_shared<ActiveEventSparse>();
+	active.frameUnderlyings = hh.frameUnderlyings;
+	active.frameHistorys = hh.frameHistorys;
+	active.underlyingOffsetIs = hh.underlyingOffsetIs;
+	active.induceVarComputeds.insert(hh.induceVarComputeds.begin(), hh.induceVarComputeds.end());
+	active.induceVarExclusions.insert(hh.induceVarExclusions.begin(), hh.induceVarExclusions.end());
+	auto z = hh.historySize;
+	active.historySparse = std::make_unique<HistorySparseArray>(z,1);
+	std::memset(active.historySparse->arr, 0, z*sizeof(std::size_t));
+	for (auto& hr0 : hh.underlyingRepa)
+	{
+		auto n = hr0->dimension;
+		auto hr = std::make_shared<HistoryRepa>();
+		hr->dimension = n;
+		hr->vectorVar = new std::size_t[n];
+		hr->shape = new std::size_t[n];
+		for (std::size_t i = 0; i < n; i++)
+		{
+			hr->vectorVar[i] = hr0->vectorVar[i];
+			hr->shape[i] = hr0->shape[i];
+		}
+		hr->size = z;
+		hr->evient = true;
+		hr->arr = new unsigned char[z*n];
+		std::memset(hr->arr, 0, z*n);
+		active.underlyingHistoryRepa.push_back(hr);
+	}
+	for (std::size_t h = 0; h < hh.underlyingSparseSize; h++)
+	{
+		auto hr = std::make_shared<HistorySparseArray>(z,1);
+		std::memset(hr->arr, 0, z*sizeof(std::size_t));
+		active.underlyingHistorySparse.push_back(hr);
+	}
+}
+
+void replay_log(Active& active, const std::string& str)
+{
+	cout << ">>> " << str << endl;
+}
+
+void run_replay_induce(Active& active, ActiveInduceParameters ppi)
+{
+	active.induce(ppi);
+}
+
+double replayPercentile(const std::vector<double>& ll, double q)
+{
+	if (!ll.size())
+		return 0.0;
+	std::size_t i = (std::size_t)(q * (double)(ll.size()-1));
+	return ll[i];
+}
+
+int main(int argc, char **argv)
+{
+	ReplayParameters pp;
+	if (!replayParse(argc, argv, pp))
+		return 1;
+
+	ActiveRecordReader reader;
+	if (!reader.open(pp.file))
+	{
+		cout << "replay\terror: failed to open recording: " << pp.file << endl;
+		return 1;
+	}
+	auto& hh = reader.header;
+
+	Active active(hh.name);
+	active.log = replay_log;
+	active.logging = pp.logging;
+	if (pp.model.size())
+	{
+		active.system = std::make_shared<ActiveSystem>();
+		ActiveIOParameters ppio;
+		ppio.filename = pp.model;
+		if (!active.load(ppio))
+		{
+			cout << "replay\terror: failed to load model: " << pp.model << endl;
+			return 1;
+		}
+		active.system->block = active.varMax() >> active.bits;
+		active.eventSparse = std::make_shared<ActiveEventSparse>();
+	}
+	else
+		replayActive(active, hh);
+	bool ok = active.underlyingHistoryRepa.size() == hh.underlyingRepa.size()
+		&& active.underlyingHistorySparse.size() == hh.underlyingSparseSize;
+	if (!ok)
+	{
+		cout << "replay\terror: model underlying inconsistent with recording" << endl;
+		return 1;
+	}
+
+	ActiveUpdateParameters ppu;
+	ActiveInduceParameters ppi;
+	ppi.logging = pp.logging;
+	if (hh.induceThreshold)
+		ppi.induceThresholds = std::set<std::size_t>{hh.induceThreshold*2, hh.induceThreshold*4, hh.induceThreshold*8};
+
+	std::thread induceThread;
+	if (pp.induce == "async")
+	{
+		ppi.asyncThreadMax = pp.asyncThreads;
+		induceThread = std::thread(run_replay_induce, std::ref(active), ppi);
+	}
+
+	ActiveRecord record;
+	std::vector<double> updateLatencies;
+	std::vector<double> induceLatencies;
+	std::vector<double> induceRecordedLatencies;
+	std::size_t updates = 0;
+	std::size_t inductions = 0;
+	std::size_t inductionsRecorded = 0;
+	std::size_t inductionsMismatched = 0;
+	double prohibitTime = 0.0;
+	auto mark = clk::now();
+	while (ok && reader.next(record))
+	{
+		if (pp.pace == "recorded")
+			std::this_thread::sleep_until(mark + std::chrono::nanoseconds(record.time));
+		if (record.type == 'U')
+		{
+			active.underlyingEventsRepa = record.eventsRepa;
+			active.underlyingEventsSparse = record.eventsSparse;
+			if (pp.induce == "async" && active.updateProhibit)
+			{
+				auto mark1 = clk::now();
+				while (active.updateProhibit && !active.terminate)
+					std::this_thread::sleep_for(std::chrono::microseconds(100));
+				prohibitTime += ((sec)(clk::now() - mark1)).count();
+			}
+			auto mark1 = clk::now();
+			ok = active.update(ppu);
+			updateLatencies.push_back(((sec)(clk::now() - mark1)).count());
+			updates++;
+			if (ok && pp.induce == "sync" && pp.induceInterval && updates % pp.induceInterval == 0)
+			{
+				auto mark2 = clk::now();
+				ok = active.induce(ppi);
+				induceLatencies.push_back(((sec)(clk::now() - mark2)).count());
+				inductions++;
+			}
+		}
+		else if (record.type == 'I')
+		{
+			inductionsRecorded++;
+			induceRecordedLatencies.push_back(record.duration);
+			if (pp.induce == "recorded" && !active.historySlicesSetEvent.count(record.slice))
+			{
+				// the replayed active has diverged from the recorded one
+				if (inductionsMismatched < 10)
+					cout << "replay\twarning: recorded slice " << record.slice << " not found" << endl;
+				inductionsMismatched++;
+			}
+			else if (pp.induce == "recorded")
+			{
+				auto mark2 = clk::now();
+				ok = active.induce(record.slice, record.induceParameters);
+				induceLatencies.push_back(((sec)(clk::now() - mark2)).count());
+				inductions++;
+			}
+		}
+	}
+	double totalTime = ((sec)(clk::now() - mark)).count();
+	if (induceThread.joinable())
+	{
+		active.terminate = true;
+		induceThread.join();
+	}
+	if (reader.bad)
+	{
+		cout << "replay\terror: truncated or corrupt record after " << updates << " updates and " << inductionsRecorded << " inductions: " << pp.file << endl;
+		return 1;
+	}
+	if (!ok)
+	{
+		cout << "replay\terror: update or induce failed" << endl;
+		return 1;
+	}
+
+	double updateTime = 0.0;
+	for (auto t : updateLatencies)
+		updateTime += t;
+	std::sort(updateLatencies.begin(), updateLatencies.end());
+	std::sort(induceLatencies.begin(), induceLatencies.end());
+	std::sort(induceRecordedLatencies.begin(), induceRecordedLatencies.end());
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	cout << std::setprecision(6);
+	cout << "updates: " << updates << endl;
+	cout << "events per second: " << (double)updates / totalTime << endl;
+	cout << "update events per second: " << (double)updates / updateTime << endl;
+	cout << "update latency p50: " << replayPercentile(updateLatencies, 0.5) * 1e6 << "us" << endl;
+	cout << "update latency p90: " << replayPercentile(updateLatencies, 0.9) * 1e6 << "us" << endl;
+	cout << "update latency p99: " << replayPercentile(updateLatencies, 0.99) * 1e6 << "us" << endl;
+	cout << "update latency max: " << (updates ? updateLatencies.back() : 0.0) * 1e6 << "us" << endl;
+	cout << "update prohibited: " << prohibitTime << "s" << endl;
+	cout << "inductions recorded: " << inductionsRecorded << endl;
+	cout << "induce recorded latency p50: " << replayPercentile(induceRecordedLatencies, 0.5) << "s" << endl;
+	cout << "induce recorded latency max: " << (induceRecordedLatencies.size() ? induceRecordedLatencies.back() : 0.0) << "s" << endl;
+	if (pp.induce == "recorded" || pp.induce == "sync")
+	{
+		cout << "inductions: " << inductions << endl;
+		if (pp.induce == "recorded")
+			cout << "inductions mismatched: " << inductionsMismatched << endl;
+		cout << "induce latency p50: " << replayPercentile(induceLatencies, 0.5) << "s" << endl;
+		cout << "induce latency max: " << (induceLatencies.size() ? induceLatencies.back() : 0.0) << "s" << endl;
+	}
+	cout << "fud cardinality: " << active.decomp->fuds.size() << endl;
+	cout << "model cardinality: " << active.decomp->fudRepasSize << endl;
+	cout << "slices: " << active.historySlicesSetEvent.size() << endl;
+	cout << "peak memory: " << usage.ru_maxrss << "KB" << endl;
+	cout << "total time: " << totalTime << "s" << endl;
+	cout << active.lockStats.report() << endl;
+
+	return 0;
+}